@@ -30,9 +30,7 @@
 
 // Como include.
 #include <Como/ClientSocket>
-#include <Como/private/Buffer>
-#include <Como/private/Protocol>
-#include <Como/private/Messages>
+#include <Como/private/Connection>
 
 
 namespace Como {
@@ -42,8 +40,16 @@ namespace Como {
 //
 
 struct ClientSocket::ClientSocketPrivate {
-	//! Buffer.
-	Buffer m_buf;
+	explicit ClientSocketPrivate( ClientSocket * q )
+		:	m_connection( new Connection( q ) )
+		,	m_isProtocol2Enabled( false )
+	{
+	}
+
+	//! Connection.
+	Connection * m_connection;
+	//! Is the protocol #2 requested when connected?
+	bool m_isProtocol2Enabled;
 }; // struct ClientSocket::ClientSocketPrivate
 
 
@@ -53,10 +59,36 @@ struct ClientSocket::ClientSocketPrivate {
 
 ClientSocket::ClientSocket( QObject * parent )
 	:	QTcpSocket( parent )
-	,	d( new ClientSocketPrivate )
+	,	d( new ClientSocketPrivate( this ) )
 {
-	connect( this, &ClientSocket::readyRead,
-		this, &ClientSocket::slotReadyRead );
+	connect( d->m_connection, &Connection::sourceHasUpdatedValue,
+		this, &ClientSocket::sourceHasUpdatedValue );
+
+	connect( d->m_connection, &Connection::getListOfSourcesMessageReceived,
+		this, &ClientSocket::getListOfSourcesMessageReceived );
+
+	connect( d->m_connection, &Connection::sourceDeinitialized,
+		this, &ClientSocket::sourceDeinitialized );
+
+	connect( d->m_connection, &Connection::subscribeMessageReceived,
+		this, &ClientSocket::subscribeMessageReceived );
+
+	connect( d->m_connection, &Connection::unsubscribeMessageReceived,
+		this, &ClientSocket::unsubscribeMessageReceived );
+
+	connect( d->m_connection, &Connection::resumeMessageReceived,
+		this, &ClientSocket::resumeMessageReceived );
+
+	// Old servers drop the connection on the preface.
+	connect( this, &ClientSocket::connected, d->m_connection,
+		[ this ] ()
+		{
+			if( d->m_isProtocol2Enabled )
+				d->m_connection->sendPreface();
+		} );
+
+	connect( this, &ClientSocket::disconnected,
+		d->m_connection, &Connection::disconnected );
 }
 
 ClientSocket::~ClientSocket()
@@ -67,113 +99,190 @@ void
 ClientSocket::connectTo( const QHostAddress & address, quint16 port )
 {
 	if( state() == QAbstractSocket::UnconnectedState )
+	{
+		d->m_connection->reset();
+
 		connectToHost( address, port );
+	}
 }
 
 void
 ClientSocket::disconnectFrom()
 {
 	if( state() != QAbstractSocket::UnconnectedState )
+	{
+		writeFrames();
+
 		disconnectFromHost();
+	}
 }
 
 void
-ClientSocket::sendSourceMessage( const Como::Source & source )
+ClientSocket::sendFrame( const Frame & frame )
+{
+	d->m_connection->sendFrame( frame );
+}
+
+void
+ClientSocket::writeFrames()
+{
+	d->m_connection->writeFrames();
+}
+
+int
+ClientSocket::maxWriteDelay() const
 {
-	SourceMessage msg( source );
+	return d->m_connection->maxWriteDelay();
+}
 
-	QSharedPointer< QByteArray > data = Protocol::writeMessage( msg );
+void
+ClientSocket::setMaxWriteDelay( int msec )
+{
+	d->m_connection->setMaxWriteDelay( msec );
+}
 
-	write( *data );
+ClientSocket::SlowClientPolicy
+ClientSocket::slowClientPolicy() const
+{
+	return d->m_connection->slowClientPolicy();
+}
 
-	flush();
+void
+ClientSocket::setSlowClientPolicy( SlowClientPolicy policy )
+{
+	d->m_connection->setSlowClientPolicy( policy );
+}
+
+qint64
+ClientSocket::maxBytesToWrite() const
+{
+	return d->m_connection->maxBytesToWrite();
 }
 
 void
-ClientSocket::sendGetListOfSourcesMessage()
+ClientSocket::setMaxBytesToWrite( qint64 bytes )
 {
-	GetListOfSourcesMessage msg;
+	d->m_connection->setMaxBytesToWrite( bytes );
+}
 
-	QSharedPointer< QByteArray > data = Protocol::writeMessage( msg );
+int
+ClientSocket::maxPendingMessages() const
+{
+	return d->m_connection->maxPendingMessages();
+}
 
-	write( *data );
+void
+ClientSocket::setMaxPendingMessages( int count )
+{
+	d->m_connection->setMaxPendingMessages( count );
+}
 
-	flush();
+int
+ClientSocket::compressionThreshold() const
+{
+	return d->m_connection->compressionThreshold();
 }
 
 void
-ClientSocket::sendDeinitSourceMessage( const Como::Source & source )
+ClientSocket::setCompressionThreshold( int bytes )
+{
+	d->m_connection->setCompressionThreshold( bytes );
+}
+
+quint64
+ClientSocket::conflatedMessagesCount() const
+{
+	return d->m_connection->conflatedMessagesCount();
+}
+
+quint64
+ClientSocket::droppedMessagesCount() const
 {
-	DeinitSourceMessage msg( source );
+	return d->m_connection->droppedMessagesCount();
+}
 
-	QSharedPointer< QByteArray > data = Protocol::writeMessage( msg );
+bool
+ClientSocket::isDisconnectedAsSlow() const
+{
+	return d->m_connection->isDisconnectedAsSlow();
+}
 
-	write( *data );
+ClientSocket::Capabilities
+ClientSocket::peerCapabilities() const
+{
+	return d->m_connection->peerCapabilities();
+}
 
-	flush();
+bool
+ClientSocket::isSourceIdsEnabled() const
+{
+	return d->m_connection->isSourceIdsEnabled();
 }
 
 void
-ClientSocket::slotReadyRead()
+ClientSocket::setSourceIdsEnabled( bool on )
 {
-	d->m_buf.write( readAll() );
+	d->m_connection->setSourceIdsEnabled( on );
+}
 
-	try {
-		while( !d->m_buf.isEmpty() )
-		{
-			int bytesRead = 0;
-
-			QSharedPointer< Message > msg =
-				Protocol::readMessage( d->m_buf.data(), bytesRead );
-
-			d->m_buf.remove( bytesRead );
-
-			if( msg.data() )
-			{
-				switch( msg->type() )
-				{
-					case GetListOfSourcesMessage::messageType :
-					{
-						emit getListOfSourcesMessageReceived();
-					} break;
-
-					case SourceMessage::messageType :
-					{
-						SourceMessage * sourceMsg =
-							static_cast< SourceMessage* > ( msg.data() );
-
-						emit sourceHasUpdatedValue( sourceMsg->source() );
-					} break;
-
-					case DeinitSourceMessage::messageType :
-					{
-						DeinitSourceMessage * deinitMsg =
-							static_cast< DeinitSourceMessage* > ( msg.data() );
-
-						emit sourceDeinitialized( deinitMsg->source() );
-					} break;
-				}
-			}
-		}
-	}
-	catch( const NotEnoughDataReceivedException & )
-	{
-	}
-	catch( const GarbageReceivedException & )
-	{
-		handleErrorInReadMessage();
-	}
-	catch( const ProtocolException & )
-	{
-		handleErrorInReadMessage();
-	}
+quint64
+ClientSocket::lastSequence() const
+{
+	return d->m_connection->lastSequence();
+}
+
+bool
+ClientSocket::isProtocol2Enabled() const
+{
+	return d->m_isProtocol2Enabled;
+}
+
+void
+ClientSocket::setProtocol2Enabled( bool on )
+{
+	d->m_isProtocol2Enabled = on;
+}
+
+Connection *
+ClientSocket::connection() const
+{
+	return d->m_connection;
+}
+
+void
+ClientSocket::sendSourceMessage( const Como::Source & source )
+{
+	d->m_connection->sendSourceMessage( source );
+}
+
+void
+ClientSocket::sendGetListOfSourcesMessage()
+{
+	d->m_connection->sendGetListOfSourcesMessage();
+}
+
+void
+ClientSocket::sendResumeMessage()
+{
+	d->m_connection->sendResumeMessage();
+}
+
+void
+ClientSocket::sendDeinitSourceMessage( const Como::Source & source )
+{
+	d->m_connection->sendDeinitSourceMessage( source );
+}
+
+void
+ClientSocket::sendSubscribeMessage( const QStringList & patterns )
+{
+	d->m_connection->sendSubscribeMessage( patterns );
 }
 
 void
-ClientSocket::handleErrorInReadMessage()
+ClientSocket::sendUnsubscribeMessage( const QStringList & patterns )
 {
-	d->m_buf.clear();
-	close();
+	d->m_connection->sendUnsubscribeMessage( patterns );
 }
 
 } /* namespace Como */
@@ -34,11 +34,14 @@
 // Qt include.
 #include <QTcpSocket>
 #include <QScopedPointer>
+#include <QStringList>
 
 
 namespace Como {
 
 class Source;
+struct Frame;
+class Connection;
 
 
 //
@@ -55,6 +58,14 @@ class Source;
 	\code
 	qRegisterMetaType< Como::Source > ( "Como::Source" );
 	\endcode
+
+	Messages are written to the socket while count of bytes
+	waiting to be written is less than maxBytesToWrite(). Other
+	messages wait in the pending queue, and when the client is
+	too slow slowClientPolicy() is applied.
+
+	Messages aren't written one by one, they are collected and
+	written with one write not later than maxWriteDelay().
 */
 class ClientSocket
 	:	public QTcpSocket
@@ -68,13 +79,164 @@ signals:
 	void getListOfSourcesMessageReceived();
 	//! De-initialization of the source.
 	void sourceDeinitialized( const Como::Source & );
+	//! Remote side subscribed to the sources with the given patterns.
+	void subscribeMessageReceived( const QStringList & patterns );
+	//! Remote side unsubscribed from the sources with the given patterns.
+	void unsubscribeMessageReceived( const QStringList & patterns );
+	//! Remote side asked for the updates missed since the given sequence.
+	void resumeMessageReceived( quint64 session, quint64 sequence );
 
 public:
+	//! Policy applied when the client can't keep up with messages.
+	enum SlowClientPolicy {
+		/*!
+			Keep only the latest pending value of each source.
+			If the pending queue is still full then the oldest
+			value is dropped.
+		*/
+		ConflatePolicy,
+		//! Drop the oldest pending value.
+		DropOldestPolicy,
+		//! Disconnect the client.
+		DisconnectPolicy
+	}; // enum SlowClientPolicy
+
+	//! Capabilities of the protocol supported by the remote side.
+	enum Capability {
+		//! List of sources can be sent in batched messages.
+		BatchedSourcesListCapability = 0x00000001,
+		//! Values of the sources can be sent with numeric ids of the sources.
+		SourceIdsCapability = 0x00000002,
+		//! Values of the numeric sources can be sent as deltas.
+		ValueDeltasCapability = 0x00000004,
+		//! Only list of sources is needed, without updates.
+		SnapshotOnlyCapability = 0x00000008,
+		//! Updates are numbered, so the session can be resumed.
+		SequencesCapability = 0x00000010,
+		//! Collected messages can be compressed.
+		CompressionCapability = 0x00000020
+	}; // enum Capability
+
+	Q_DECLARE_FLAGS( Capabilities, Capability )
+
 	ClientSocket( QObject * parent = 0 );
 	~ClientSocket();
 
+	/*!
+		Send already serialized message.
+
+		ServerSocket serializes message only once and
+		sends the same frame to all clients with this method.
+	*/
+	void sendFrame( const Frame & frame );
+
+	/*!
+		\return Maximum delay in milliseconds of the message
+		before it will be written to the socket.
+	*/
+	int maxWriteDelay() const;
+	/*!
+		Set maximum delay in milliseconds of the message before
+		it will be written to the socket. All messages sent during
+		this delay are written with one write. Zero (by default)
+		means that messages are written at the end of the current
+		iteration of the event loop.
+	*/
+	void setMaxWriteDelay( int msec );
+
+	//! \return Policy applied when the client is too slow.
+	SlowClientPolicy slowClientPolicy() const;
+	//! Set policy applied when the client is too slow.
+	void setSlowClientPolicy( SlowClientPolicy policy );
+
+	/*!
+		\return Maximum count of bytes waiting to be written
+		to the socket. Zero (by default) means unlimited.
+	*/
+	qint64 maxBytesToWrite() const;
+	//! Set maximum count of bytes waiting to be written to the socket.
+	void setMaxBytesToWrite( qint64 bytes );
+
+	/*!
+		\return Maximum count of messages in the pending queue.
+		Zero means unlimited.
+	*/
+	int maxPendingMessages() const;
+	//! Set maximum count of messages in the pending queue.
+	void setMaxPendingMessages( int count );
+
+	/*!
+		\return Minimum size in bytes of the collected messages
+		to be compressed. Zero (by default) disables compression.
+	*/
+	int compressionThreshold() const;
+	/*!
+		Set minimum size in bytes of the collected messages to be
+		compressed. Messages are compressed only if the remote side
+		supports CompressionCapability, smaller portions of messages
+		and incompressible data are written as is.
+	*/
+	void setCompressionThreshold( int bytes );
+
+	//! \return Count of values replaced by the newer value of the same source.
+	quint64 conflatedMessagesCount() const;
+	//! \return Count of dropped values.
+	quint64 droppedMessagesCount() const;
+	//! \return Was the client disconnected because it was too slow?
+	bool isDisconnectedAsSlow() const;
+
+	/*!
+		\return Capabilities of the remote side. They are
+		known after receiving of GetListOfSourcesMessage.
+	*/
+	Capabilities peerCapabilities() const;
+
+	/*!
+		\return Are values of the sources sent with numeric
+		ids only?
+	*/
+	bool isSourceIdsEnabled() const;
+	/*!
+		Enable sending of values of the sources with numeric
+		ids only. ServerSocket enables it after the remote side
+		with SourceIdsCapability received ids of all sources.
+
+		If the remote side supports ValueDeltasCapability too
+		then values of the numeric sources are sent as deltas.
+	*/
+	void setSourceIdsEnabled( bool on );
+
+	/*!
+		\return Sequence number of the last update received from
+		the server, zero if the server doesn't number updates.
+	*/
+	quint64 lastSequence() const;
+
+	/*!
+		\return Is the protocol #2 requested when connected?
+		False by default.
+	*/
+	bool isProtocol2Enabled() const;
+	/*!
+		Request the protocol #2 with the preface when connected.
+		Capabilities of the protocol #2 (ids of the sources, deltas,
+		sequences, compression) are available only with it. Servers
+		before the protocol #2 drop the connection on the preface,
+		so enable it only for servers known to support it. Takes
+		effect on the next connection.
+	*/
+	void setProtocol2Enabled( bool on );
+
+	//! \return Connection implementing the protocol. For internal use.
+	Connection * connection() const;
+
 public slots:
-	//! Connect to host.
+	/*!
+		Connect to host.
+
+		Received sources are kept, so after reconnection
+		the session can be resumed with sendResumeMessage().
+	*/
 	void connectTo( const QHostAddress & address, quint16 port );
 
 	//! Disconnect from host.
@@ -86,22 +248,41 @@ public slots:
 	//! Send request to receive all available sources.
 	void sendGetListOfSourcesMessage();
 
+	/*!
+		Send request to receive updates missed since lastSequence().
+		If server doesn't have them anymore it sends all available
+		sources, and sources de-initialized while we were disconnected
+		are reported with sourceDeinitialized(). Without previous
+		session it's the same as sendGetListOfSourcesMessage().
+	*/
+	void sendResumeMessage();
+
 	//! Send information about de-initialization of the source.
 	void sendDeinitSourceMessage( const Como::Source & source );
 
-private:
-	//! Handle errors in read message.
-	void handleErrorInReadMessage();
+	/*!
+		Subscribe to the sources with the given patterns.
 
-private slots:
-	//! New data available.
-	void slotReadyRead();
+		Pattern is the exact name of the source or the prefix
+		of the name ending with '*'. Patterns with '*' anywhere
+		else are ignored by the server. Until the first subscription
+		all sources are received.
+	*/
+	void sendSubscribeMessage( const QStringList & patterns );
+
+	//! Unsubscribe from the sources with the given patterns.
+	void sendUnsubscribeMessage( const QStringList & patterns );
+
+	//! Write all collected messages right now.
+	void writeFrames();
 
 private:
 	struct ClientSocketPrivate;
 	QScopedPointer< ClientSocketPrivate > d;
 }; // class ClientSocket
 
+Q_DECLARE_OPERATORS_FOR_FLAGS( ClientSocket::Capabilities )
+
 } /* namespace Como */
 
 #endif // COMO__CLIENT_SOCKET_HPP__INCLUDED
@@ -0,0 +1,268 @@
+
+/*!
+	\file
+
+	\author Igor Mironchik (igor.mironchik at gmail dot com).
+
+	Copyright (c) 2012 Igor Mironchik
+
+	Permission is hereby granted, free of charge, to any person
+	obtaining a copy of this software and associated documentation
+	files (the "Software"), to deal in the Software without
+	restriction, including without limitation the rights to use,
+	copy, modify, merge, publish, distribute, sublicense, and/or sell
+	copies of the Software, and to permit persons to whom the
+	Software is furnished to do so, subject to the following
+	conditions:
+
+	The above copyright notice and this permission notice shall be
+	included in all copies or substantial portions of the Software.
+
+	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+	EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+	OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+	NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+	HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+	WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+	FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+	OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+// Como include.
+#include <Como/LocalClientSocket>
+#include <Como/private/Connection>
+
+
+namespace Como {
+
+//
+// LocalClientSocket::LocalClientSocketPrivate
+//
+
+struct LocalClientSocket::LocalClientSocketPrivate {
+	explicit LocalClientSocketPrivate( LocalClientSocket * q )
+		:	m_connection( new Connection( q ) )
+	{
+	}
+
+	//! Connection.
+	Connection * m_connection;
+}; // struct LocalClientSocket::LocalClientSocketPrivate
+
+
+//
+// LocalClientSocket
+//
+
+LocalClientSocket::LocalClientSocket( QObject * parent )
+	:	QLocalSocket( parent )
+	,	d( new LocalClientSocketPrivate( this ) )
+{
+	connect( d->m_connection, &Connection::sourceHasUpdatedValue,
+		this, &LocalClientSocket::sourceHasUpdatedValue );
+
+	connect( d->m_connection, &Connection::getListOfSourcesMessageReceived,
+		this, &LocalClientSocket::getListOfSourcesMessageReceived );
+
+	connect( d->m_connection, &Connection::sourceDeinitialized,
+		this, &LocalClientSocket::sourceDeinitialized );
+
+	connect( d->m_connection, &Connection::subscribeMessageReceived,
+		this, &LocalClientSocket::subscribeMessageReceived );
+
+	connect( d->m_connection, &Connection::unsubscribeMessageReceived,
+		this, &LocalClientSocket::unsubscribeMessageReceived );
+
+	connect( d->m_connection, &Connection::resumeMessageReceived,
+		this, &LocalClientSocket::resumeMessageReceived );
+
+	connect( this, &LocalClientSocket::connected,
+		d->m_connection, &Connection::sendPreface );
+
+	connect( this, &LocalClientSocket::disconnected,
+		d->m_connection, &Connection::disconnected );
+}
+
+LocalClientSocket::~LocalClientSocket()
+{
+}
+
+void
+LocalClientSocket::connectTo( const QString & name )
+{
+	if( state() == QLocalSocket::UnconnectedState )
+	{
+		d->m_connection->reset();
+
+		connectToServer( name );
+	}
+}
+
+void
+LocalClientSocket::disconnectFrom()
+{
+	if( state() != QLocalSocket::UnconnectedState )
+	{
+		writeFrames();
+
+		disconnectFromServer();
+	}
+}
+
+void
+LocalClientSocket::sendFrame( const Frame & frame )
+{
+	d->m_connection->sendFrame( frame );
+}
+
+void
+LocalClientSocket::writeFrames()
+{
+	d->m_connection->writeFrames();
+}
+
+int
+LocalClientSocket::maxWriteDelay() const
+{
+	return d->m_connection->maxWriteDelay();
+}
+
+void
+LocalClientSocket::setMaxWriteDelay( int msec )
+{
+	d->m_connection->setMaxWriteDelay( msec );
+}
+
+ClientSocket::SlowClientPolicy
+LocalClientSocket::slowClientPolicy() const
+{
+	return d->m_connection->slowClientPolicy();
+}
+
+void
+LocalClientSocket::setSlowClientPolicy( ClientSocket::SlowClientPolicy policy )
+{
+	d->m_connection->setSlowClientPolicy( policy );
+}
+
+qint64
+LocalClientSocket::maxBytesToWrite() const
+{
+	return d->m_connection->maxBytesToWrite();
+}
+
+void
+LocalClientSocket::setMaxBytesToWrite( qint64 bytes )
+{
+	d->m_connection->setMaxBytesToWrite( bytes );
+}
+
+int
+LocalClientSocket::maxPendingMessages() const
+{
+	return d->m_connection->maxPendingMessages();
+}
+
+void
+LocalClientSocket::setMaxPendingMessages( int count )
+{
+	d->m_connection->setMaxPendingMessages( count );
+}
+
+int
+LocalClientSocket::compressionThreshold() const
+{
+	return d->m_connection->compressionThreshold();
+}
+
+void
+LocalClientSocket::setCompressionThreshold( int bytes )
+{
+	d->m_connection->setCompressionThreshold( bytes );
+}
+
+quint64
+LocalClientSocket::conflatedMessagesCount() const
+{
+	return d->m_connection->conflatedMessagesCount();
+}
+
+quint64
+LocalClientSocket::droppedMessagesCount() const
+{
+	return d->m_connection->droppedMessagesCount();
+}
+
+bool
+LocalClientSocket::isDisconnectedAsSlow() const
+{
+	return d->m_connection->isDisconnectedAsSlow();
+}
+
+ClientSocket::Capabilities
+LocalClientSocket::peerCapabilities() const
+{
+	return d->m_connection->peerCapabilities();
+}
+
+bool
+LocalClientSocket::isSourceIdsEnabled() const
+{
+	return d->m_connection->isSourceIdsEnabled();
+}
+
+void
+LocalClientSocket::setSourceIdsEnabled( bool on )
+{
+	d->m_connection->setSourceIdsEnabled( on );
+}
+
+quint64
+LocalClientSocket::lastSequence() const
+{
+	return d->m_connection->lastSequence();
+}
+
+Connection *
+LocalClientSocket::connection() const
+{
+	return d->m_connection;
+}
+
+void
+LocalClientSocket::sendSourceMessage( const Como::Source & source )
+{
+	d->m_connection->sendSourceMessage( source );
+}
+
+void
+LocalClientSocket::sendGetListOfSourcesMessage()
+{
+	d->m_connection->sendGetListOfSourcesMessage();
+}
+
+void
+LocalClientSocket::sendResumeMessage()
+{
+	d->m_connection->sendResumeMessage();
+}
+
+void
+LocalClientSocket::sendDeinitSourceMessage( const Como::Source & source )
+{
+	d->m_connection->sendDeinitSourceMessage( source );
+}
+
+void
+LocalClientSocket::sendSubscribeMessage( const QStringList & patterns )
+{
+	d->m_connection->sendSubscribeMessage( patterns );
+}
+
+void
+LocalClientSocket::sendUnsubscribeMessage( const QStringList & patterns )
+{
+	d->m_connection->sendUnsubscribeMessage( patterns );
+}
+
+} /* namespace Como */
@@ -0,0 +1,206 @@
+
+/*!
+	\file
+
+	\author Igor Mironchik (igor.mironchik at gmail dot com).
+
+	Copyright (c) 2012 Igor Mironchik
+
+	Permission is hereby granted, free of charge, to any person
+	obtaining a copy of this software and associated documentation
+	files (the "Software"), to deal in the Software without
+	restriction, including without limitation the rights to use,
+	copy, modify, merge, publish, distribute, sublicense, and/or sell
+	copies of the Software, and to permit persons to whom the
+	Software is furnished to do so, subject to the following
+	conditions:
+
+	The above copyright notice and this permission notice shall be
+	included in all copies or substantial portions of the Software.
+
+	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+	EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+	OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+	NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+	HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+	WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+	FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+	OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#ifndef COMO__LOCAL_CLIENT_SOCKET_HPP__INCLUDED
+#define COMO__LOCAL_CLIENT_SOCKET_HPP__INCLUDED
+
+// Como include.
+#include <Como/ClientSocket>
+
+// Qt include.
+#include <QLocalSocket>
+#include <QScopedPointer>
+#include <QStringList>
+
+
+namespace Como {
+
+class Source;
+struct Frame;
+class Connection;
+
+
+//
+// LocalClientSocket
+//
+
+/*!
+	Local client socket. This is the counterpart of the
+	ClientSocket for the clients on the same host, it's
+	connected to the ServerSocket with Unix domain socket
+	(named pipe on Windows) instead of TCP.
+
+	The protocol and all settings are the same as of ClientSocket.
+
+	\sa ServerSocket::listenLocal().
+*/
+class LocalClientSocket
+	:	public QLocalSocket
+{
+	Q_OBJECT
+
+signals:
+	//! Source has updated his value.
+	void sourceHasUpdatedValue( const Como::Source & );
+	//! GetListOfSourcesMessage request received
+	void getListOfSourcesMessageReceived();
+	//! De-initialization of the source.
+	void sourceDeinitialized( const Como::Source & );
+	//! Remote side subscribed to the sources with the given patterns.
+	void subscribeMessageReceived( const QStringList & patterns );
+	//! Remote side unsubscribed from the sources with the given patterns.
+	void unsubscribeMessageReceived( const QStringList & patterns );
+	//! Remote side asked for the updates missed since the given sequence.
+	void resumeMessageReceived( quint64 session, quint64 sequence );
+
+public:
+	LocalClientSocket( QObject * parent = 0 );
+	~LocalClientSocket();
+
+	/*!
+		Send already serialized message.
+
+		\sa ClientSocket::sendFrame().
+	*/
+	void sendFrame( const Frame & frame );
+
+	//! \return Maximum delay in milliseconds of the message before writing.
+	int maxWriteDelay() const;
+	/*!
+		Set maximum delay in milliseconds of the message before writing.
+
+		\sa ClientSocket::setMaxWriteDelay().
+	*/
+	void setMaxWriteDelay( int msec );
+
+	//! \return Policy applied when the client is too slow.
+	ClientSocket::SlowClientPolicy slowClientPolicy() const;
+	//! Set policy applied when the client is too slow.
+	void setSlowClientPolicy( ClientSocket::SlowClientPolicy policy );
+
+	/*!
+		\return Maximum count of bytes waiting to be written
+		to the socket. Zero (by default) means unlimited.
+	*/
+	qint64 maxBytesToWrite() const;
+	//! Set maximum count of bytes waiting to be written to the socket.
+	void setMaxBytesToWrite( qint64 bytes );
+
+	/*!
+		\return Maximum count of messages in the pending queue.
+		Zero means unlimited.
+	*/
+	int maxPendingMessages() const;
+	//! Set maximum count of messages in the pending queue.
+	void setMaxPendingMessages( int count );
+
+	//! \return Minimum size in bytes of the collected messages to be compressed.
+	int compressionThreshold() const;
+	/*!
+		Set minimum size in bytes of the collected messages to be compressed.
+
+		\sa ClientSocket::setCompressionThreshold().
+	*/
+	void setCompressionThreshold( int bytes );
+
+	//! \return Count of values replaced by the newer value of the same source.
+	quint64 conflatedMessagesCount() const;
+	//! \return Count of dropped values.
+	quint64 droppedMessagesCount() const;
+	//! \return Was the client disconnected because it was too slow?
+	bool isDisconnectedAsSlow() const;
+
+	//! \return Capabilities of the remote side.
+	ClientSocket::Capabilities peerCapabilities() const;
+
+	//! \return Are values of the sources sent with numeric ids only?
+	bool isSourceIdsEnabled() const;
+	/*!
+		Enable sending of values of the sources with numeric ids only.
+
+		\sa ClientSocket::setSourceIdsEnabled().
+	*/
+	void setSourceIdsEnabled( bool on );
+
+	//! \return Sequence number of the last update received from the server.
+	quint64 lastSequence() const;
+
+	//! \return Connection implementing the protocol. For internal use.
+	Connection * connection() const;
+
+public slots:
+	/*!
+		Connect to the local server with the given name.
+
+		Received sources are kept, so after reconnection
+		the session can be resumed with sendResumeMessage().
+	*/
+	void connectTo( const QString & name );
+
+	//! Disconnect from the server.
+	void disconnectFrom();
+
+	//! Send information about source.
+	void sendSourceMessage( const Como::Source & source );
+
+	//! Send request to receive all available sources.
+	void sendGetListOfSourcesMessage();
+
+	/*!
+		Send request to receive updates missed since lastSequence().
+
+		\sa ClientSocket::sendResumeMessage().
+	*/
+	void sendResumeMessage();
+
+	//! Send information about de-initialization of the source.
+	void sendDeinitSourceMessage( const Como::Source & source );
+
+	/*!
+		Subscribe to the sources with the given patterns.
+
+		\sa ClientSocket::sendSubscribeMessage().
+	*/
+	void sendSubscribeMessage( const QStringList & patterns );
+
+	//! Unsubscribe from the sources with the given patterns.
+	void sendUnsubscribeMessage( const QStringList & patterns );
+
+	//! Write all collected messages right now.
+	void writeFrames();
+
+private:
+	struct LocalClientSocketPrivate;
+	QScopedPointer< LocalClientSocketPrivate > d;
+}; // class LocalClientSocket
+
+} /* namespace Como */
+
+#endif // COMO__LOCAL_CLIENT_SOCKET_HPP__INCLUDED
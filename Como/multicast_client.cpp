@@ -0,0 +1,318 @@
+
+/*!
+	\file
+
+	\author Igor Mironchik (igor.mironchik at gmail dot com).
+
+	Copyright (c) 2012 Igor Mironchik
+
+	Permission is hereby granted, free of charge, to any person
+	obtaining a copy of this software and associated documentation
+	files (the "Software"), to deal in the Software without
+	restriction, including without limitation the rights to use,
+	copy, modify, merge, publish, distribute, sublicense, and/or sell
+	copies of the Software, and to permit persons to whom the
+	Software is furnished to do so, subject to the following
+	conditions:
+
+	The above copyright notice and this permission notice shall be
+	included in all copies or substantial portions of the Software.
+
+	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+	EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+	OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+	NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+	HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+	WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+	FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+	OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+// Como include.
+#include <Como/MulticastClient>
+#include <Como/Source>
+#include <Como/private/MulticastDatagram>
+#include <Como/private/ReceivedSources>
+#include <Como/private/Buffer>
+#include <Como/private/Protocol>
+#include <Como/private/Messages>
+
+// Qt include.
+#include <QUdpSocket>
+#include <QTcpSocket>
+#include <QNetworkDatagram>
+
+
+namespace Como {
+
+//
+// MulticastClient::MulticastClientPrivate
+//
+
+struct MulticastClient::MulticastClientPrivate
+	:	public MessageVisitor
+{
+	explicit MulticastClientPrivate( MulticastClient * q )
+		:	m_receivedSources(
+				[ q ] ( const Source & source )
+					{ emit q->sourceHasUpdatedValue( source ); },
+				[ q ] ( const Source & source )
+					{ emit q->sourceDeinitialized( source ); },
+				[ q ] () { q->sendGetListOfSourcesMessage(); } )
+		,	m_udp( 0 )
+		,	m_tcp( 0 )
+		,	m_decoder( Protocol::Version1 )
+		,	m_nextSequence( 0 )
+		,	m_lostDatagramsCount( 0 )
+		,	m_isSourcesListRequested( false )
+		,	m_isOutOfSync( false )
+	{
+	}
+
+	//! Handle message from the server.
+	virtual void visit( const Message & msg )
+	{
+		if( !ReceivedSources::isSourcesMessage( msg.type() ) )
+			return;
+
+		if( msg.type() == SourcesListMessage::messageType )
+			m_isSourcesListRequested = false;
+
+		if( !m_receivedSources.handleMessage( msg ) )
+			m_isOutOfSync = true;
+	}
+
+	/*!
+		Handle messages from the datagram.
+
+		\return false if data is corrupted or we are out of sync.
+	*/
+	bool handleMessages( QByteArrayView data )
+	{
+		MessageDecoder decoder;
+
+		m_isOutOfSync = false;
+
+		while( !data.isEmpty() && !m_isOutOfSync )
+		{
+			// Datagrams contain only complete messages.
+			if( decoder.decode( data, *this ) != MessageDecoder::MessageDecoded )
+				return false;
+
+			data = data.sliced( decoder.bytesRead() );
+		}
+
+		return !m_isOutOfSync;
+	}
+
+	//! Sources received from the server.
+	ReceivedSources m_receivedSources;
+	//! Multicast socket.
+	QUdpSocket * m_udp;
+	//! Connection to the server for lists of sources.
+	QTcpSocket * m_tcp;
+	//! Buffer of the data from the server.
+	Buffer m_buf;
+	//! Decoder of the messages from the server.
+	MessageDecoder m_decoder;
+	//! Address of the multicast group.
+	QHostAddress m_groupAddress;
+	//! Expected sequence number of the next datagram.
+	quint64 m_nextSequence;
+	//! Count of detected lost datagrams.
+	quint64 m_lostDatagramsCount;
+	//! Is list of sources requested and not received yet?
+	bool m_isSourcesListRequested;
+	//! Was delta of the unknown value received?
+	bool m_isOutOfSync;
+}; // struct MulticastClient::MulticastClientPrivate
+
+
+//
+// MulticastClient
+//
+
+MulticastClient::MulticastClient( QObject * parent )
+	:	QObject( parent )
+	,	d( new MulticastClientPrivate( this ) )
+{
+}
+
+MulticastClient::~MulticastClient()
+{
+	disconnectFrom();
+}
+
+quint64
+MulticastClient::lostDatagramsCount() const
+{
+	return d->m_lostDatagramsCount;
+}
+
+bool
+MulticastClient::connectTo( const QHostAddress & groupAddress,
+	quint16 groupPort, const QHostAddress & serverAddress, quint16 serverPort )
+{
+	disconnectFrom();
+
+	QUdpSocket * udp = new QUdpSocket( this );
+
+	const QHostAddress any =
+		( groupAddress.protocol() == QAbstractSocket::IPv6Protocol ?
+			QHostAddress::AnyIPv6 : QHostAddress::AnyIPv4 );
+
+	if( !udp->bind( any, groupPort, QUdpSocket::ShareAddress |
+			QUdpSocket::ReuseAddressHint ) ||
+		!udp->joinMulticastGroup( groupAddress ) )
+	{
+		delete udp;
+
+		return false;
+	}
+
+	d->m_udp = udp;
+	d->m_groupAddress = groupAddress;
+	d->m_nextSequence = 0;
+	d->m_receivedSources.clear();
+
+	connect( d->m_udp, &QUdpSocket::readyRead,
+		this, &MulticastClient::slotReadDatagrams );
+
+	d->m_tcp = new QTcpSocket( this );
+
+	connect( d->m_tcp, &QTcpSocket::connected,
+		this, &MulticastClient::slotConnected );
+
+	connect( d->m_tcp, &QTcpSocket::readyRead,
+		this, &MulticastClient::slotReadyRead );
+
+	connect( d->m_tcp, &QTcpSocket::disconnected,
+		this, &MulticastClient::disconnectFrom );
+
+	d->m_tcp->connectToHost( serverAddress, serverPort );
+
+	return true;
+}
+
+void
+MulticastClient::disconnectFrom()
+{
+	if( !d->m_udp )
+		return;
+
+	const bool wasConnected =
+		( d->m_tcp->state() == QAbstractSocket::ConnectedState );
+
+	d->m_udp->leaveMulticastGroup( d->m_groupAddress );
+	d->m_udp->deleteLater();
+	d->m_udp = 0;
+
+	d->m_tcp->disconnect( this );
+	d->m_tcp->abort();
+	d->m_tcp->deleteLater();
+	d->m_tcp = 0;
+
+	d->m_buf.clear();
+	d->m_decoder.reset( Protocol::Version1 );
+
+	if( wasConnected )
+		emit disconnected();
+}
+
+void
+MulticastClient::sendGetListOfSourcesMessage()
+{
+	if( !d->m_tcp || d->m_isSourcesListRequested ||
+		d->m_tcp->state() != QAbstractSocket::ConnectedState )
+			return;
+
+	GetListOfSourcesMessage msg( GetListOfSourcesMessage::BatchedSourcesList |
+		GetListOfSourcesMessage::SourceIds |
+		GetListOfSourcesMessage::SnapshotOnly );
+
+	// Server writes lists of sources in the protocol #1,
+	// because we never send the preface.
+	d->m_tcp->write( *Protocol::writeMessage( msg, Protocol::Version1 ) );
+
+	d->m_isSourcesListRequested = true;
+}
+
+void
+MulticastClient::slotReadDatagrams()
+{
+	while( d->m_udp && d->m_udp->hasPendingDatagrams() )
+	{
+		const QByteArray datagram = d->m_udp->receiveDatagram().data();
+
+		quint64 sequence = 0;
+
+		if( !MulticastDatagram::readHeader( datagram, sequence ) )
+			continue;
+
+		// Late duplicate or reordered datagram.
+		if( d->m_nextSequence && sequence < d->m_nextSequence )
+			continue;
+
+		if( d->m_nextSequence && sequence != d->m_nextSequence )
+		{
+			d->m_lostDatagramsCount += sequence - d->m_nextSequence;
+
+			sendGetListOfSourcesMessage();
+		}
+
+		d->m_nextSequence = sequence + 1;
+
+		if( !d->handleMessages( QByteArrayView( datagram ).sliced(
+			MulticastDatagram::c_headerSize ) ) )
+				sendGetListOfSourcesMessage();
+	}
+}
+
+void
+MulticastClient::slotConnected()
+{
+	d->m_isSourcesListRequested = false;
+
+	emit connected();
+
+	sendGetListOfSourcesMessage();
+}
+
+void
+MulticastClient::slotReadyRead()
+{
+	d->m_buf.readFrom( d->m_tcp );
+
+	while( !d->m_buf.isEmpty() )
+	{
+		d->m_isOutOfSync = false;
+
+		switch( d->m_decoder.decode( d->m_buf.data(), *d ) )
+		{
+			case MessageDecoder::NeedMoreData :
+				return;
+
+			case MessageDecoder::MessageDecoded :
+			{
+				d->m_buf.remove( d->m_decoder.bytesRead() );
+
+				if( d->m_isOutOfSync )
+				{
+					disconnectFrom();
+
+					return;
+				}
+			} break;
+
+			// We never send the preface, so server must not send it too.
+			default :
+			{
+				disconnectFrom();
+
+				return;
+			}
+		}
+	}
+}
+
+} /* namespace Como */
@@ -0,0 +1,130 @@
+
+/*!
+	\file
+
+	\author Igor Mironchik (igor.mironchik at gmail dot com).
+
+	Copyright (c) 2012 Igor Mironchik
+
+	Permission is hereby granted, free of charge, to any person
+	obtaining a copy of this software and associated documentation
+	files (the "Software"), to deal in the Software without
+	restriction, including without limitation the rights to use,
+	copy, modify, merge, publish, distribute, sublicense, and/or sell
+	copies of the Software, and to permit persons to whom the
+	Software is furnished to do so, subject to the following
+	conditions:
+
+	The above copyright notice and this permission notice shall be
+	included in all copies or substantial portions of the Software.
+
+	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+	EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+	OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+	NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+	HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+	WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+	FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+	OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#ifndef COMO__MULTICAST_CLIENT_HPP__INCLUDED
+#define COMO__MULTICAST_CLIENT_HPP__INCLUDED
+
+// Qt include.
+#include <QObject>
+#include <QScopedPointer>
+#include <QHostAddress>
+
+
+namespace Como {
+
+class Source;
+
+
+//
+// MulticastClient
+//
+
+/*!
+	Client of the ServerSocket receiving updates of the
+	sources from the multicast group.
+
+	Updates are received as UDP datagrams sent by
+	ServerSocket::startMulticast(). List of sources is
+	requested over TCP connection to the ServerSocket,
+	this connection doesn't receive updates. Lost datagrams
+	are detected by sequence numbers and list of sources
+	is requested again.
+
+	Provides the same signals about sources as ClientSocket.
+
+	Don't forget register Source meta-type information in Qt with:
+
+	\code
+	qRegisterMetaType< Como::Source > ( "Como::Source" );
+	\endcode
+*/
+class MulticastClient
+	:	public QObject
+{
+	Q_OBJECT
+
+signals:
+	//! Source has updated his value.
+	void sourceHasUpdatedValue( const Como::Source & );
+	//! De-initialization of the source.
+	void sourceDeinitialized( const Como::Source & );
+	//! Connected to the server.
+	void connected();
+	//! Disconnected from the server.
+	void disconnected();
+
+public:
+	explicit MulticastClient( QObject * parent = 0 );
+	~MulticastClient();
+
+	//! \return Count of detected lost datagrams.
+	quint64 lostDatagramsCount() const;
+
+public slots:
+	/*!
+		Join multicast group and connect to the server
+		for the lists of sources.
+
+		\return false if multicast group can't be joined.
+	*/
+	bool connectTo(
+		//! Address of the multicast group.
+		const QHostAddress & groupAddress,
+		//! Port of the multicast group.
+		quint16 groupPort,
+		//! Address of the server.
+		const QHostAddress & serverAddress,
+		//! Port of the server.
+		quint16 serverPort );
+
+	//! Leave multicast group and disconnect from the server.
+	void disconnectFrom();
+
+	//! Request list of all sources.
+	void sendGetListOfSourcesMessage();
+
+private slots:
+	//! Datagrams received.
+	void slotReadDatagrams();
+	//! Connected to the server.
+	void slotConnected();
+	//! Data received from the server.
+	void slotReadyRead();
+
+private:
+	Q_DISABLE_COPY( MulticastClient )
+
+	struct MulticastClientPrivate;
+	QScopedPointer< MulticastClientPrivate > d;
+}; // class MulticastClient
+
+} /* namespace Como */
+
+#endif // COMO__MULTICAST_CLIENT_HPP__INCLUDED
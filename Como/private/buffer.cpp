@@ -31,6 +31,9 @@
 // Como include.
 #include <Como/private/Buffer>
 
+// Qt include.
+#include <QIODevice>
+
 
 namespace Como {
 
@@ -39,43 +42,85 @@ namespace Como {
 //
 
 Buffer::Buffer()
+	:	m_pos( 0 )
 {
 }
 
-const QByteArray &
+QByteArrayView
 Buffer::data() const
 {
-	return m_data;
+	return QByteArrayView( m_data ).sliced( m_pos );
 }
 
 void
 Buffer::write( const QByteArray & data )
 {
+	compact();
+
 	m_data.append( data );
 }
 
+qint64
+Buffer::readFrom( QIODevice * device )
+{
+	const qint64 available = device->bytesAvailable();
+
+	if( available <= 0 )
+		return 0;
+
+	compact();
+
+	const int oldSize = m_data.size();
+
+	m_data.resize( oldSize + available );
+
+	const qint64 bytesRead = device->read( m_data.data() + oldSize, available );
+
+	m_data.resize( oldSize + qMax( bytesRead, qint64( 0 ) ) );
+
+	return bytesRead;
+}
+
 void
 Buffer::remove( int bytes )
 {
-	m_data.remove( 0, bytes );
+	m_pos += qMin( bytes, size() );
+
+	// Keep allocated memory for the next data.
+	if( m_pos == m_data.size() )
+	{
+		m_data.resize( 0 );
+		m_pos = 0;
+	}
 }
 
 void
 Buffer::clear()
 {
 	m_data.clear();
+	m_pos = 0;
 }
 
 bool
 Buffer::isEmpty() const
 {
-	return m_data.isEmpty();
+	return ( m_pos == m_data.size() );
 }
 
 int
 Buffer::size() const
 {
-	return m_data.size();
+	return m_data.size() - m_pos;
+}
+
+void
+Buffer::compact()
+{
+	if( m_pos > 0 && m_pos >= size() )
+	{
+		m_data.remove( 0, m_pos );
+		m_pos = 0;
+	}
 }
 
 } /* namespace Como */
@@ -33,6 +33,11 @@
 
 // Qt include.
 #include <QByteArray>
+#include <QByteArrayView>
+
+QT_BEGIN_NAMESPACE
+class QIODevice;
+QT_END_NAMESPACE
 
 
 namespace Como {
@@ -41,17 +46,32 @@ namespace Como {
 // Buffer
 //
 
-//! Buffer of the ClientSocket.
+/*!
+	Buffer of the received data.
+
+	Removing from the beginning only moves read position, not read
+	data is moved to the front lazily when new data is written and
+	at least as many bytes were removed, so each byte is moved
+	at most once on average. Data always stays contiguous.
+*/
 class Buffer {
 public:
 	Buffer();
 
-	//! \return Data of the buffer.
-	const QByteArray & data() const;
+	//! \return Data of the buffer, valid until the next write.
+	QByteArrayView data() const;
 
 	//! Write data to the end of the buffer.
 	void write( const QByteArray & data );
 
+	/*!
+		Read all available data from the device to the end
+		of the buffer, without temporary QByteArray.
+
+		\return Count of read bytes, -1 on error.
+	*/
+	qint64 readFrom( QIODevice * device );
+
 	//! Remove first bytes from the beginning of the buffer.
 	void remove( int bytes );
 
@@ -64,9 +84,15 @@ public:
 	//! \return Size of the buffer.
 	int size() const;
 
+private:
+	//! Move not read data to the front if it's cheap enough.
+	void compact();
+
 private:
 	//! Data.
 	QByteArray m_data;
+	//! Read position.
+	int m_pos;
 }; // class Buffer
 
 } /* namespace Como */
@@ -0,0 +1,388 @@
+
+/*!
+	\file
+
+	\author Igor Mironchik (igor.mironchik at gmail dot com).
+
+	Copyright (c) 2012 Igor Mironchik
+
+	Permission is hereby granted, free of charge, to any person
+	obtaining a copy of this software and associated documentation
+	files (the "Software"), to deal in the Software without
+	restriction, including without limitation the rights to use,
+	copy, modify, merge, publish, distribute, sublicense, and/or sell
+	copies of the Software, and to permit persons to whom the
+	Software is furnished to do so, subject to the following
+	conditions:
+
+	The above copyright notice and this permission notice shall be
+	included in all copies or substantial portions of the Software.
+
+	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+	EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+	OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+	NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+	HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+	WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+	FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+	OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+// Como include.
+#include <Como/private/ClientsGroup>
+
+// Qt include.
+#include <QAbstractSocket>
+
+
+namespace Como {
+
+//
+// ClientSocketSettings
+//
+
+void
+ClientSocketSettings::apply( Connection * connection ) const
+{
+	connection->setSlowClientPolicy( m_policy );
+	connection->setMaxBytesToWrite( m_maxBytesToWrite );
+	connection->setMaxPendingMessages( m_maxPendingMessages );
+	connection->setMaxWriteDelay( m_maxWriteDelay );
+	connection->setCompressionThreshold( m_compressionThreshold );
+
+	QAbstractSocket * socket =
+		qobject_cast< QAbstractSocket* > ( connection->device() );
+
+	if( socket )
+		socket->setSocketOption( QAbstractSocket::LowDelayOption,
+			m_isLowDelay ? 1 : 0 );
+}
+
+
+//
+// ClientsGroup
+//
+
+ClientsGroup::ClientsGroup( QObject * parent )
+	:	QObject( parent )
+	,	m_disconnectedConflatedCount( 0 )
+	,	m_disconnectedDroppedCount( 0 )
+	,	m_conflatedCount( 0 )
+	,	m_droppedCount( 0 )
+	,	m_slowClientsDisconnectedCount( 0 )
+{
+}
+
+ClientsGroup::~ClientsGroup()
+{
+}
+
+void
+ClientsGroup::addClient( qintptr socketDescriptor )
+{
+	ClientSocket * socket = new ClientSocket( this );
+
+	if( socket->setSocketDescriptor( socketDescriptor ) )
+	{
+		addConnection( socket->connection() );
+
+		emit clientConnected( socket );
+	}
+	else
+		delete socket;
+}
+
+void
+ClientsGroup::addLocalClient( quintptr socketDescriptor )
+{
+	LocalClientSocket * socket = new LocalClientSocket( this );
+
+	if( socket->setSocketDescriptor( socketDescriptor ) )
+	{
+		addConnection( socket->connection() );
+
+		emit localClientConnected( socket );
+	}
+	else
+		delete socket;
+}
+
+void
+ClientsGroup::addConnection( Connection * connection )
+{
+	m_settings.apply( connection );
+
+	connect( connection, &Connection::disconnected,
+		this, &ClientsGroup::slotClientDisconnected,
+		Qt::QueuedConnection );
+
+	connect( connection, &Connection::getListOfSourcesMessageReceived,
+		this, &ClientsGroup::slotGetListOfSourcesMessageReceived );
+
+	connect( connection, &Connection::resumeMessageReceived,
+		this, &ClientsGroup::slotResumeMessageReceived );
+
+	connect( connection, &Connection::subscribeMessageReceived,
+		this, &ClientsGroup::slotSubscribeMessageReceived );
+
+	connect( connection, &Connection::unsubscribeMessageReceived,
+		this, &ClientsGroup::slotUnsubscribeMessageReceived );
+
+	m_connections.append( connection );
+	m_allSourcesConnections.append( connection );
+}
+
+void
+ClientsGroup::sendFrames( const QList< Frame > & frames )
+{
+	if( m_patterns.isEmpty() )
+	{
+		foreach( Connection * connection, m_allSourcesConnections )
+		{
+			foreach( const Frame & frame, frames )
+				connection->sendFrame( frame );
+		}
+	}
+	else
+	{
+		QSet< Connection* > subscribed;
+
+		foreach( const Frame & frame, frames )
+		{
+			if( !frame.isSourceFrame() )
+			{
+				foreach( Connection * connection, m_connections )
+				{
+					if( !m_snapshotOnlyConnections.contains( connection ) )
+						connection->sendFrame( frame );
+				}
+
+				continue;
+			}
+
+			foreach( Connection * connection, m_allSourcesConnections )
+				connection->sendFrame( frame );
+
+			subscribed.clear();
+
+			m_subscriptions.match( frame.m_key.first, subscribed );
+
+			foreach( Connection * connection, subscribed )
+				connection->sendFrame( frame );
+		}
+	}
+
+	updateStatistics();
+}
+
+void
+ClientsGroup::sendFrames( Connection * connection,
+	const QList< Frame > & frames, bool isSourceIdsEnabled )
+{
+	if( !m_connections.contains( connection ) )
+		return;
+
+	if( isSourceIdsEnabled )
+		connection->setSourceIdsEnabled( true );
+
+	foreach( const Frame & frame, frames )
+	{
+		if( isSubscribed( connection, frame ) )
+			connection->sendRequestedFrame( frame );
+	}
+
+	updateStatistics();
+}
+
+void
+ClientsGroup::setSettings( const ClientSocketSettings & settings )
+{
+	m_settings = settings;
+
+	foreach( Connection * connection, m_connections )
+		m_settings.apply( connection );
+}
+
+quint64
+ClientsGroup::conflatedMessagesCount() const
+{
+	return m_conflatedCount.load( std::memory_order_relaxed );
+}
+
+quint64
+ClientsGroup::droppedMessagesCount() const
+{
+	return m_droppedCount.load( std::memory_order_relaxed );
+}
+
+quint64
+ClientsGroup::slowClientsDisconnectedCount() const
+{
+	return m_slowClientsDisconnectedCount.load( std::memory_order_relaxed );
+}
+
+void
+ClientsGroup::slotClientDisconnected()
+{
+	Connection * connection = qobject_cast< Connection* > ( sender() );
+
+	if( !m_connections.removeOne( connection ) )
+		return;
+
+	removeSubscriptions( connection );
+	m_allSourcesConnections.removeOne( connection );
+	m_snapshotOnlyConnections.remove( connection );
+
+	m_disconnectedConflatedCount += connection->conflatedMessagesCount();
+	m_disconnectedDroppedCount += connection->droppedMessagesCount();
+
+	if( connection->isDisconnectedAsSlow() )
+		m_slowClientsDisconnectedCount.fetch_add( 1, std::memory_order_relaxed );
+
+	updateStatistics();
+
+	QIODevice * device = connection->device();
+
+	if( ClientSocket * socket = qobject_cast< ClientSocket* > ( device ) )
+		emit clientDisconnected( socket );
+	else if( LocalClientSocket * socket =
+		qobject_cast< LocalClientSocket* > ( device ) )
+			emit localClientDisconnected( socket );
+}
+
+void
+ClientsGroup::slotGetListOfSourcesMessageReceived()
+{
+	Connection * connection = qobject_cast< Connection* > ( sender() );
+
+	emit getListOfSourcesRequested( connection,
+		requestedCapabilities( connection ) );
+}
+
+void
+ClientsGroup::slotResumeMessageReceived( quint64 session, quint64 sequence )
+{
+	Connection * connection = qobject_cast< Connection* > ( sender() );
+
+	emit resumeRequested( connection, requestedCapabilities( connection ),
+		session, sequence );
+}
+
+ClientSocket::Capabilities
+ClientsGroup::requestedCapabilities( Connection * connection )
+{
+	ClientSocket::Capabilities capabilities = connection->peerCapabilities();
+
+	if( capabilities.testFlag( ClientSocket::SnapshotOnlyCapability ) &&
+		!m_snapshotOnlyConnections.contains( connection ) )
+	{
+		m_snapshotOnlyConnections.insert( connection );
+		m_allSourcesConnections.removeOne( connection );
+	}
+
+	// Batched list can't be filtered, so subscribed client
+	// receives the list source by source.
+	if( m_patterns.contains( connection ) )
+		capabilities.setFlag( ClientSocket::BatchedSourcesListCapability,
+			false );
+
+	return capabilities;
+}
+
+void
+ClientsGroup::slotSubscribeMessageReceived( const QStringList & patterns )
+{
+	Connection * connection = qobject_cast< Connection* > ( sender() );
+
+	if( !m_connections.contains( connection ) )
+		return;
+
+	// Pattern with '*' not at the end would subscribe
+	// to more sources than the client asked for.
+	QStringList valid;
+
+	foreach( const QString & pattern, patterns )
+	{
+		if( PrefixTrie< Connection* >::isValid( pattern ) )
+			valid.append( pattern );
+	}
+
+	if( valid.isEmpty() )
+		return;
+
+	QSet< QString > & connectionPatterns = m_patterns[ connection ];
+
+	if( connectionPatterns.isEmpty() )
+		m_allSourcesConnections.removeOne( connection );
+
+	foreach( const QString & pattern, valid )
+	{
+		if( !connectionPatterns.contains( pattern ) )
+		{
+			connectionPatterns.insert( pattern );
+			m_subscriptions.add( pattern, connection );
+		}
+	}
+}
+
+void
+ClientsGroup::slotUnsubscribeMessageReceived( const QStringList & patterns )
+{
+	Connection * connection = qobject_cast< Connection* > ( sender() );
+
+	if( !m_patterns.contains( connection ) )
+		return;
+
+	QSet< QString > & connectionPatterns = m_patterns[ connection ];
+
+	foreach( const QString & pattern, patterns )
+	{
+		if( connectionPatterns.remove( pattern ) )
+			m_subscriptions.remove( pattern, connection );
+	}
+
+	// Client without subscriptions receives all sources again.
+	if( connectionPatterns.isEmpty() )
+	{
+		m_patterns.remove( connection );
+
+		if( !m_snapshotOnlyConnections.contains( connection ) )
+			m_allSourcesConnections.append( connection );
+	}
+}
+
+bool
+ClientsGroup::isSubscribed( Connection * connection, const Frame & frame ) const
+{
+	if( !frame.isSourceFrame() || !m_patterns.contains( connection ) )
+		return true;
+
+	return m_subscriptions.isMatched( frame.m_key.first, connection );
+}
+
+void
+ClientsGroup::removeSubscriptions( Connection * connection )
+{
+	foreach( const QString & pattern, m_patterns.value( connection ) )
+		m_subscriptions.remove( pattern, connection );
+
+	m_patterns.remove( connection );
+}
+
+void
+ClientsGroup::updateStatistics()
+{
+	quint64 conflated = m_disconnectedConflatedCount;
+	quint64 dropped = m_disconnectedDroppedCount;
+
+	foreach( Connection * connection, m_connections )
+	{
+		conflated += connection->conflatedMessagesCount();
+		dropped += connection->droppedMessagesCount();
+	}
+
+	m_conflatedCount.store( conflated, std::memory_order_relaxed );
+	m_droppedCount.store( dropped, std::memory_order_relaxed );
+}
+
+} /* namespace Como */
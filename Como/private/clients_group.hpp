@@ -0,0 +1,218 @@
+
+/*!
+	\file
+
+	\author Igor Mironchik (igor.mironchik at gmail dot com).
+
+	Copyright (c) 2012 Igor Mironchik
+
+	Permission is hereby granted, free of charge, to any person
+	obtaining a copy of this software and associated documentation
+	files (the "Software"), to deal in the Software without
+	restriction, including without limitation the rights to use,
+	copy, modify, merge, publish, distribute, sublicense, and/or sell
+	copies of the Software, and to permit persons to whom the
+	Software is furnished to do so, subject to the following
+	conditions:
+
+	The above copyright notice and this permission notice shall be
+	included in all copies or substantial portions of the Software.
+
+	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+	EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+	OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+	NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+	HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+	WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+	FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+	OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#ifndef COMO__CLIENTS_GROUP_HPP__INCLUDED
+#define COMO__CLIENTS_GROUP_HPP__INCLUDED
+
+// Como include.
+#include <Como/ClientSocket>
+#include <Como/LocalClientSocket>
+#include <Como/private/Connection>
+#include <Como/private/Frame>
+#include <Como/private/PrefixTrie>
+
+// Qt include.
+#include <QObject>
+#include <QList>
+#include <QHash>
+#include <QSet>
+#include <QStringList>
+
+// C++ include.
+#include <atomic>
+
+
+namespace Como {
+
+//
+// ClientSocketSettings
+//
+
+//! Settings applied to each client of the ServerSocket.
+struct ClientSocketSettings {
+	ClientSocketSettings()
+		:	m_policy( ClientSocket::ConflatePolicy )
+		,	m_maxBytesToWrite( 0 )
+		,	m_maxPendingMessages( 1000 )
+		,	m_maxWriteDelay( 0 )
+		,	m_isLowDelay( false )
+		,	m_compressionThreshold( 1024 )
+	{
+	}
+
+	//! Apply settings to the connection.
+	void apply( Connection * connection ) const;
+
+	//! Slow client policy.
+	ClientSocket::SlowClientPolicy m_policy;
+	//! Maximum count of bytes waiting to be written.
+	qint64 m_maxBytesToWrite;
+	//! Maximum count of pending messages.
+	int m_maxPendingMessages;
+	//! Maximum delay of the message before writing.
+	int m_maxWriteDelay;
+	//! Is TCP_NODELAY set? Ignored for local clients.
+	bool m_isLowDelay;
+	//! Minimum size of the collected messages to be compressed.
+	int m_compressionThreshold;
+}; // struct ClientSocketSettings
+
+
+//
+// ClientsGroup
+//
+
+/*!
+	Group of the clients served by one thread.
+
+	ServerSocket distributes accepted connections between
+	groups, each group lives in its own I/O thread and owns
+	its client sockets, both TCP and local ones. Methods of this class must be invoked
+	in the thread of the group, except statistics getters.
+
+	Clients without subscriptions receive all sources, other
+	clients receive only sources matched by their subscriptions.
+	Clients with SnapshotOnlyCapability receive only lists of
+	sources they have requested.
+*/
+class ClientsGroup
+	:	public QObject
+{
+	Q_OBJECT
+
+signals:
+	//! New client has connected.
+	void clientConnected( Como::ClientSocket* );
+	/*!
+		Client has disconnected. Receiver must delete the socket
+		later, when it doesn't need it any more.
+	*/
+	void clientDisconnected( Como::ClientSocket* );
+	//! New local client has connected.
+	void localClientConnected( Como::LocalClientSocket* );
+	/*!
+		Local client has disconnected. Receiver must delete the socket
+		later, when it doesn't need it any more.
+	*/
+	void localClientDisconnected( Como::LocalClientSocket* );
+	//! Client requested list of all sources.
+	void getListOfSourcesRequested( Como::Connection*,
+		Como::ClientSocket::Capabilities );
+	//! Client requested updates missed since the given sequence.
+	void resumeRequested( Como::Connection*,
+		Como::ClientSocket::Capabilities, quint64 session, quint64 sequence );
+
+public:
+	explicit ClientsGroup( QObject * parent = 0 );
+	~ClientsGroup();
+
+	//! Add client with the given socket descriptor.
+	void addClient( qintptr socketDescriptor );
+	//! Add local client with the given socket descriptor.
+	void addLocalClient( quintptr socketDescriptor );
+
+	//! Send frames to all clients.
+	void sendFrames( const QList< Frame > & frames );
+
+	/*!
+		Send frames to the given connection if it's still connected.
+		If isSourceIdsEnabled is true then later values are sent
+		to this client with ids of the sources.
+	*/
+	void sendFrames( Connection * connection, const QList< Frame > & frames,
+		bool isSourceIdsEnabled = false );
+
+	//! Set settings of the clients.
+	void setSettings( const ClientSocketSettings & settings );
+
+	//! \return Count of conflated values.
+	quint64 conflatedMessagesCount() const;
+	//! \return Count of dropped values.
+	quint64 droppedMessagesCount() const;
+	//! \return Count of clients disconnected because they were too slow.
+	quint64 slowClientsDisconnectedCount() const;
+
+private slots:
+	//! Client was disconnected.
+	void slotClientDisconnected();
+	//! Received GetListOfSourcesMessage message.
+	void slotGetListOfSourcesMessageReceived();
+	//! Received ResumeMessage message.
+	void slotResumeMessageReceived( quint64 session, quint64 sequence );
+	//! Client subscribed to the sources.
+	void slotSubscribeMessageReceived( const QStringList & patterns );
+	//! Client unsubscribed from the sources.
+	void slotUnsubscribeMessageReceived( const QStringList & patterns );
+
+private:
+	//! Start serving of the connection.
+	void addConnection( Connection * connection );
+	/*!
+		\return Capabilities of the client that requested
+		sources, adjusted to its subscriptions.
+	*/
+	ClientSocket::Capabilities requestedCapabilities( Connection * connection );
+	//! Update statistics available from other threads.
+	void updateStatistics();
+	//! \return Should the frame be sent to the given client?
+	bool isSubscribed( Connection * connection, const Frame & frame ) const;
+	//! Remove all subscriptions of the client.
+	void removeSubscriptions( Connection * connection );
+
+private:
+	Q_DISABLE_COPY( ClientsGroup )
+
+	//! Connections of the clients.
+	QList< Connection* > m_connections;
+	//! Connections without subscriptions.
+	QList< Connection* > m_allSourcesConnections;
+	//! Connections that don't receive updates.
+	QSet< Connection* > m_snapshotOnlyConnections;
+	//! Patterns of the subscribed clients.
+	QHash< Connection*, QSet< QString > > m_patterns;
+	//! Subscriptions of the clients.
+	PrefixTrie< Connection* > m_subscriptions;
+	//! Settings of the clients.
+	ClientSocketSettings m_settings;
+	//! Count of conflated values of disconnected clients.
+	quint64 m_disconnectedConflatedCount;
+	//! Count of dropped values of disconnected clients.
+	quint64 m_disconnectedDroppedCount;
+	//! Count of conflated values.
+	std::atomic< quint64 > m_conflatedCount;
+	//! Count of dropped values.
+	std::atomic< quint64 > m_droppedCount;
+	//! Count of clients disconnected because they were too slow.
+	std::atomic< quint64 > m_slowClientsDisconnectedCount;
+}; // class ClientsGroup
+
+} /* namespace Como */
+
+#endif // COMO__CLIENTS_GROUP_HPP__INCLUDED
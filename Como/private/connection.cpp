@@ -0,0 +1,920 @@
+
+/*!
+	\file
+
+	\author Igor Mironchik (igor.mironchik at gmail dot com).
+
+	Copyright (c) 2012 Igor Mironchik
+
+	Permission is hereby granted, free of charge, to any person
+	obtaining a copy of this software and associated documentation
+	files (the "Software"), to deal in the Software without
+	restriction, including without limitation the rights to use,
+	copy, modify, merge, publish, distribute, sublicense, and/or sell
+	copies of the Software, and to permit persons to whom the
+	Software is furnished to do so, subject to the following
+	conditions:
+
+	The above copyright notice and this permission notice shall be
+	included in all copies or substantial portions of the Software.
+
+	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+	EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+	OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+	NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+	HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+	WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+	FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+	OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+// Como include.
+#include <Como/private/Connection>
+#include <Como/private/Buffer>
+#include <Como/private/Protocol>
+#include <Como/private/Messages>
+#include <Como/private/Frame>
+#include <Como/private/SourceKey>
+#include <Como/private/ReceivedSources>
+
+// Qt include.
+#include <QIODevice>
+#include <QAbstractSocket>
+#include <QLocalSocket>
+#include <QHash>
+#include <QTimer>
+
+// C++ include.
+#include <list>
+#include <iterator>
+
+
+namespace Como {
+
+/*!
+	Maximum size of the frames compressed together. Size of
+	the message is 16 bits in the protocol #1, so compressed
+	data must fit into it.
+*/
+static const int c_maxChunkSize = 32 * 1024;
+
+
+//
+// Connection::ConnectionPrivate
+//
+
+struct Connection::ConnectionPrivate {
+	//! Type of the pending queue.
+	typedef std::list< Frame > PendingQueue;
+
+	ConnectionPrivate( Connection * q, QIODevice * device )
+		:	m_device( device )
+		,	m_policy( ClientSocket::ConflatePolicy )
+		,	m_maxBytesToWrite( 0 )
+		,	m_maxPendingMessages( 1000 )
+		,	m_conflatedCount( 0 )
+		,	m_droppedCount( 0 )
+		,	m_isDisconnectedAsSlow( false )
+		,	m_compressionThreshold( 0 )
+		,	m_requestedBytes( 0 )
+		,	m_maxWriteDelay( 0 )
+		,	m_writeTimer( 0 )
+		,	m_isSourceIdsEnabled( false )
+		,	m_receivedSources(
+				[ q ] ( const Source & source )
+					{ emit q->sourceHasUpdatedValue( source ); },
+				[ q ] ( const Source & source )
+					{ emit q->sourceDeinitialized( source ); },
+				[ this, q ] ()
+					{
+						if( !m_isSourcesListRequested )
+							q->sendGetListOfSourcesMessage();
+					} )
+		,	m_isSourcesListRequested( false )
+		,	m_session( 0 )
+		,	m_lastSequence( 0 )
+		,	m_isSequenceReplyAwaited( false )
+		,	m_isDecompressing( false )
+		,	m_isCompressionRequested( false )
+		,	m_decoder( Protocol::Version1 )
+		,	m_writeVersion( Protocol::Version1 )
+	{
+	}
+
+	//! Remove frame from the pending queue.
+	PendingQueue::iterator removePending( PendingQueue::iterator it )
+	{
+		if( it->m_kind == Frame::SourceValue )
+		{
+			const auto value = m_pendingValues.find( it->m_key );
+
+			if( value != m_pendingValues.end() && value.value() == it )
+				m_pendingValues.erase( value );
+		}
+
+		return m_pending.erase( it );
+	}
+
+	//! Device.
+	QIODevice * m_device;
+	//! Buffer.
+	Buffer m_buf;
+	//! Frames waiting to be written.
+	PendingQueue m_pending;
+	//! Latest pending value of each source.
+	QHash< SourceKey, PendingQueue::iterator > m_pendingValues;
+	//! Slow client policy.
+	ClientSocket::SlowClientPolicy m_policy;
+	//! Maximum count of bytes waiting to be written.
+	qint64 m_maxBytesToWrite;
+	//! Maximum count of messages in the pending queue.
+	int m_maxPendingMessages;
+	//! Count of conflated values.
+	quint64 m_conflatedCount;
+	//! Count of dropped values.
+	quint64 m_droppedCount;
+	//! Was client disconnected because it was too slow?
+	bool m_isDisconnectedAsSlow;
+	//! Capabilities of the remote side.
+	ClientSocket::Capabilities m_peerCapabilities;
+	//! Frames collected to be written with one write.
+	QByteArray m_outgoing;
+	//! Frames collected to be compressed.
+	QByteArray m_chunk;
+	//! Minimum size of the collected frames to be compressed.
+	int m_compressionThreshold;
+	/*!
+		Count of bytes of the frames requested by the remote side
+		that are collected or written but not confirmed yet.
+	*/
+	qint64 m_requestedBytes;
+	//! Maximum delay of the frame before writing.
+	int m_maxWriteDelay;
+	//! Timer of the delayed writing.
+	QTimer * m_writeTimer;
+	//! Are values sent with ids of the sources?
+	bool m_isSourceIdsEnabled;
+	//! Sources received from the remote side.
+	ReceivedSources m_receivedSources;
+	//! Is list of sources requested and not received yet?
+	bool m_isSourcesListRequested;
+	//! Last values written to the remote side by ids of the sources.
+	QHash< quint32, QVariant > m_sentValues;
+	//! Session of the remote side.
+	quint64 m_session;
+	//! Sequence number of the last update received from the remote side.
+	quint64 m_lastSequence;
+	/*!
+		Is reply to our request awaited? Until it's received
+		sequence numbers of the updates are ignored, because
+		some updates before them may be not received yet.
+	*/
+	bool m_isSequenceReplyAwaited;
+	//! Are messages of CompressedMessage being handled?
+	bool m_isDecompressing;
+	/*!
+		Did we tell the remote side that we accept CompressedMessage?
+		Only clients do, so servers never inflate data of clients.
+	*/
+	bool m_isCompressionRequested;
+	//! Decoder of the received messages.
+	MessageDecoder m_decoder;
+	//! Version of the protocol of the written messages.
+	Protocol::Version m_writeVersion;
+}; // struct Connection::ConnectionPrivate
+
+
+//
+// Connection
+//
+
+Connection::Connection( QIODevice * device )
+	:	QObject( device )
+	,	d( new ConnectionPrivate( this, device ) )
+{
+	connect( device, &QIODevice::readyRead,
+		this, &Connection::slotReadyRead );
+
+	connect( device, &QIODevice::bytesWritten,
+		this, &Connection::slotBytesWritten );
+
+	d->m_writeTimer = new QTimer( this );
+	d->m_writeTimer->setSingleShot( true );
+
+	connect( d->m_writeTimer, &QTimer::timeout,
+		this, &Connection::writeFrames );
+}
+
+Connection::~Connection()
+{
+}
+
+QIODevice *
+Connection::device() const
+{
+	return d->m_device;
+}
+
+void
+Connection::reset()
+{
+	d->m_writeTimer->stop();
+	d->m_buf.clear();
+	d->m_pending.clear();
+	d->m_pendingValues.clear();
+	d->m_outgoing.clear();
+	d->m_chunk.clear();
+	d->m_requestedBytes = 0;
+	d->m_sentValues.clear();
+	d->m_peerCapabilities = ClientSocket::Capabilities();
+	d->m_isSourceIdsEnabled = false;
+	d->m_isDisconnectedAsSlow = false;
+	d->m_isSourcesListRequested = false;
+	d->m_isSequenceReplyAwaited = false;
+	d->m_isDecompressing = false;
+	d->m_isCompressionRequested = false;
+	d->m_decoder.reset( Protocol::Version1 );
+	d->m_writeVersion = Protocol::Version1;
+}
+
+void
+Connection::sendFrame( const Frame & frame )
+{
+	sendFrame( frame, false );
+}
+
+void
+Connection::sendRequestedFrame( const Frame & frame )
+{
+	sendFrame( frame, true );
+}
+
+void
+Connection::sendFrame( const Frame & frame, bool isRequested )
+{
+	if( d->m_isDisconnectedAsSlow )
+		return;
+
+	if( frame.m_kind == Frame::Sequence &&
+		!d->m_peerCapabilities.testFlag( ClientSocket::SequencesCapability ) )
+			return;
+
+	if( d->m_isSourceIdsEnabled && !frame.m_compactData.isEmpty() )
+	{
+		Frame compact = frame;
+		compact.m_data = frame.m_compactData;
+		compact.m_compactData = FramePayload();
+
+		sendFrame( compact, isRequested );
+
+		return;
+	}
+
+	// Requested frames never make the client slow.
+	if( d->m_pending.empty() &&
+		( isRequested || canWrite( frame.m_data.data().size() ) ) )
+			collectFrame( frame, isRequested );
+	else
+		queueFrame( frame, isRequested );
+}
+
+void
+Connection::sendPreface()
+{
+	if( d->m_writeVersion == Protocol::Version2 )
+		return;
+
+	// Collected messages are written in the protocol #1.
+	flushChunk();
+
+	d->m_outgoing.append( Protocol::preface() );
+	d->m_writeVersion = Protocol::Version2;
+
+	writeFrames();
+}
+
+void
+Connection::writeFrames()
+{
+	d->m_writeTimer->stop();
+
+	flushChunk();
+
+	if( !d->m_outgoing.isEmpty() )
+	{
+		d->m_device->write( d->m_outgoing );
+
+		d->m_outgoing.clear();
+	}
+}
+
+int
+Connection::maxWriteDelay() const
+{
+	return d->m_maxWriteDelay;
+}
+
+void
+Connection::setMaxWriteDelay( int msec )
+{
+	d->m_maxWriteDelay = qMax( msec, 0 );
+}
+
+ClientSocket::SlowClientPolicy
+Connection::slowClientPolicy() const
+{
+	return d->m_policy;
+}
+
+void
+Connection::setSlowClientPolicy( ClientSocket::SlowClientPolicy policy )
+{
+	d->m_policy = policy;
+}
+
+qint64
+Connection::maxBytesToWrite() const
+{
+	return d->m_maxBytesToWrite;
+}
+
+void
+Connection::setMaxBytesToWrite( qint64 bytes )
+{
+	d->m_maxBytesToWrite = qMax( bytes, qint64( 0 ) );
+}
+
+int
+Connection::maxPendingMessages() const
+{
+	return d->m_maxPendingMessages;
+}
+
+void
+Connection::setMaxPendingMessages( int count )
+{
+	d->m_maxPendingMessages = qMax( count, 0 );
+}
+
+quint64
+Connection::conflatedMessagesCount() const
+{
+	return d->m_conflatedCount;
+}
+
+quint64
+Connection::droppedMessagesCount() const
+{
+	return d->m_droppedCount;
+}
+
+bool
+Connection::isDisconnectedAsSlow() const
+{
+	return d->m_isDisconnectedAsSlow;
+}
+
+ClientSocket::Capabilities
+Connection::peerCapabilities() const
+{
+	return d->m_peerCapabilities;
+}
+
+bool
+Connection::isSourceIdsEnabled() const
+{
+	return d->m_isSourceIdsEnabled;
+}
+
+void
+Connection::setSourceIdsEnabled( bool on )
+{
+	d->m_isSourceIdsEnabled = on;
+}
+
+quint64
+Connection::lastSequence() const
+{
+	return d->m_lastSequence;
+}
+
+int
+Connection::compressionThreshold() const
+{
+	return d->m_compressionThreshold;
+}
+
+void
+Connection::setCompressionThreshold( int bytes )
+{
+	d->m_compressionThreshold = qMax( bytes, 0 );
+}
+
+void
+Connection::sendSourceMessage( const Como::Source & source )
+{
+	SourceMessage msg( source );
+
+	sendFrame( Frame( Frame::SourceValue,
+		*Protocol::writeMessage( msg ), sourceKey( source ) ) );
+}
+
+void
+Connection::sendGetListOfSourcesMessage()
+{
+	GetListOfSourcesMessage msg( capabilities() );
+
+	d->m_isSourcesListRequested = true;
+	d->m_isSequenceReplyAwaited = true;
+	d->m_isCompressionRequested = true;
+
+	sendFrame( Frame( Frame::Other, *Protocol::writeMessage( msg ) ) );
+}
+
+void
+Connection::sendResumeMessage()
+{
+	if( d->m_session == 0 )
+	{
+		sendGetListOfSourcesMessage();
+
+		return;
+	}
+
+	ResumeMessage msg( capabilities(), d->m_session, d->m_lastSequence );
+
+	d->m_isSourcesListRequested = true;
+	d->m_isSequenceReplyAwaited = true;
+	d->m_isCompressionRequested = true;
+	d->m_receivedSources.beginResume();
+
+	sendFrame( Frame( Frame::Other, *Protocol::writeMessage( msg ) ) );
+}
+
+quint32
+Connection::capabilities()
+{
+	return ( GetListOfSourcesMessage::BatchedSourcesList |
+		GetListOfSourcesMessage::SourceIds |
+		GetListOfSourcesMessage::ValueDeltas |
+		GetListOfSourcesMessage::Sequences |
+		GetListOfSourcesMessage::Compression );
+}
+
+void
+Connection::sendDeinitSourceMessage( const Como::Source & source )
+{
+	DeinitSourceMessage msg( source );
+
+	sendFrame( Frame( Frame::SourceDeinit,
+		*Protocol::writeMessage( msg ), sourceKey( source ) ) );
+}
+
+void
+Connection::sendSubscribeMessage( const QStringList & patterns )
+{
+	SubscribeMessage msg( patterns );
+
+	sendFrame( Frame( Frame::Other, *Protocol::writeMessage( msg ) ) );
+}
+
+void
+Connection::sendUnsubscribeMessage( const QStringList & patterns )
+{
+	UnsubscribeMessage msg( patterns );
+
+	sendFrame( Frame( Frame::Other, *Protocol::writeMessage( msg ) ) );
+}
+
+void
+Connection::slotReadyRead()
+{
+	d->m_buf.readFrom( d->m_device );
+
+	while( !d->m_buf.isEmpty() )
+	{
+		switch( d->m_decoder.decode( d->m_buf.data(), *this ) )
+		{
+			case MessageDecoder::NeedMoreData :
+				return;
+
+			case MessageDecoder::PrefaceDecoded :
+			{
+				d->m_buf.remove( d->m_decoder.bytesRead() );
+
+				// Remote side supports protocol #2, so do we.
+				sendPreface();
+			} break;
+
+			case MessageDecoder::MessageDecoded :
+				d->m_buf.remove( d->m_decoder.bytesRead() );
+			break;
+
+			default :
+			{
+				handleErrorInReadMessage();
+
+				return;
+			}
+		}
+	}
+}
+
+void
+Connection::visit( const Message & msg )
+{
+	if( ReceivedSources::isSourcesMessage( msg.type() ) )
+	{
+		switch( msg.type() )
+		{
+			case SourcesListMessage::messageType :
+			case InitSourceMessage::messageType :
+				d->m_isSourcesListRequested = false;
+			break;
+
+			default :
+				break;
+		}
+
+		if( !d->m_receivedSources.handleMessage( msg ) )
+			handleErrorInReadMessage();
+
+		return;
+	}
+
+	switch( msg.type() )
+	{
+		case GetListOfSourcesMessage::messageType :
+		{
+			const GetListOfSourcesMessage & getListMsg =
+				static_cast< const GetListOfSourcesMessage& > ( msg );
+
+			d->m_peerCapabilities = ClientSocket::Capabilities(
+				QFlag( getListMsg.capabilities() ) );
+
+			emit getListOfSourcesMessageReceived();
+		} break;
+
+		case SubscribeMessage::messageType :
+		{
+			const SubscribeMessage & subscribeMsg =
+				static_cast< const SubscribeMessage& > ( msg );
+
+			emit subscribeMessageReceived( subscribeMsg.patterns() );
+		} break;
+
+		case UnsubscribeMessage::messageType :
+		{
+			const UnsubscribeMessage & unsubscribeMsg =
+				static_cast< const UnsubscribeMessage& > ( msg );
+
+			emit unsubscribeMessageReceived( unsubscribeMsg.patterns() );
+		} break;
+
+		case ResumeMessage::messageType :
+		{
+			const ResumeMessage & resumeMsg =
+				static_cast< const ResumeMessage& > ( msg );
+
+			d->m_peerCapabilities = ClientSocket::Capabilities(
+				QFlag( resumeMsg.capabilities() ) );
+
+			emit resumeMessageReceived( resumeMsg.session(),
+				resumeMsg.sequence() );
+		} break;
+
+		case SequenceMessage::messageType :
+			handleSequenceMessage(
+				static_cast< const SequenceMessage& > ( msg ) );
+		break;
+
+		case CompressedMessage::messageType :
+		{
+			// Compressed messages are never nested and are sent
+			// only to the side that accepts them.
+			if( d->m_isDecompressing || !d->m_isCompressionRequested )
+				handleErrorInReadMessage();
+			else
+				handleCompressedMessage(
+					static_cast< const CompressedMessage& > ( msg ) );
+		} break;
+
+		default :
+			break;
+	}
+}
+
+void
+Connection::handleCompressedMessage( const CompressedMessage & msg )
+{
+	const QByteArray data = Protocol::uncompressMessages( msg.compressed() );
+
+	if( data.isEmpty() )
+	{
+		handleErrorInReadMessage();
+
+		return;
+	}
+
+	MessageDecoder decoder( d->m_decoder.version() );
+
+	d->m_isDecompressing = true;
+
+	int pos = 0;
+
+	// Error in the visited message stops decompressing.
+	while( pos < data.size() && d->m_isDecompressing )
+	{
+		// Compressed messages are always complete.
+		if( decoder.decode( QByteArrayView( data ).sliced( pos ), *this ) !=
+			MessageDecoder::MessageDecoded )
+		{
+			handleErrorInReadMessage();
+
+			break;
+		}
+
+		pos += decoder.bytesRead();
+	}
+
+	d->m_isDecompressing = false;
+}
+
+void
+Connection::handleSequenceMessage( const SequenceMessage & msg )
+{
+	if( msg.kind() == SequenceMessage::Updates )
+	{
+		if( !d->m_isSequenceReplyAwaited && msg.session() == d->m_session )
+			d->m_lastSequence = msg.sequence();
+
+		return;
+	}
+
+	d->m_isSequenceReplyAwaited = false;
+	d->m_isSourcesListRequested = false;
+	d->m_session = msg.session();
+	d->m_lastSequence = msg.sequence();
+
+	d->m_receivedSources.endResume( msg.kind() == SequenceMessage::Snapshot );
+}
+
+void
+Connection::handleErrorInReadMessage()
+{
+	d->m_buf.clear();
+	d->m_decoder.reset( Protocol::Version1 );
+	d->m_isDecompressing = false;
+	d->m_device->close();
+}
+
+void
+Connection::abortDevice()
+{
+	if( QAbstractSocket * socket = qobject_cast< QAbstractSocket* > ( d->m_device ) )
+		socket->abort();
+	else if( QLocalSocket * socket = qobject_cast< QLocalSocket* > ( d->m_device ) )
+		socket->abort();
+	else
+		d->m_device->close();
+}
+
+bool
+Connection::canWrite( int bytes ) const
+{
+	if( d->m_maxBytesToWrite == 0 )
+		return true;
+
+	// Frames requested by the client, list of sources for
+	// example, aren't the backlog of the slow client.
+	const qint64 waiting = qMax( d->m_device->bytesToWrite() +
+		d->m_outgoing.size() + d->m_chunk.size() - d->m_requestedBytes,
+		qint64( 0 ) );
+
+	return ( waiting == 0 || waiting + bytes <= d->m_maxBytesToWrite );
+}
+
+void
+Connection::queueFrame( const Frame & frame, bool isRequested )
+{
+	switch( d->m_policy )
+	{
+		case ClientSocket::DisconnectPolicy :
+		{
+			if( isRequested )
+				break;
+
+			d->m_isDisconnectedAsSlow = true;
+			d->m_pending.clear();
+			d->m_pendingValues.clear();
+			d->m_outgoing.clear();
+			d->m_chunk.clear();
+			d->m_requestedBytes = 0;
+
+			abortDevice();
+		} return;
+
+		case ClientSocket::ConflatePolicy :
+		{
+			if( frame.m_kind == Frame::SourceValue )
+			{
+				const auto it = d->m_pendingValues.constFind( frame.m_key );
+
+				if( it != d->m_pendingValues.constEnd() )
+				{
+					*it.value() = frame;
+
+					++d->m_conflatedCount;
+
+					return;
+				}
+			}
+		} break;
+
+		default :
+			break;
+	}
+
+	d->m_pending.push_back( frame );
+
+	if( frame.m_kind == Frame::SourceValue )
+		d->m_pendingValues.insert( frame.m_key,
+			std::prev( d->m_pending.end() ) );
+	else if( frame.m_kind == Frame::SourceDeinit )
+		d->m_pendingValues.remove( frame.m_key );
+
+	while( d->m_maxPendingMessages > 0 &&
+		(int) d->m_pending.size() > d->m_maxPendingMessages )
+	{
+		if( !dropOldestPendingValue() )
+			break;
+	}
+}
+
+bool
+Connection::dropOldestPendingValue()
+{
+	for( auto it = d->m_pending.begin(), last = d->m_pending.end();
+		it != last; ++it )
+	{
+		if( it->m_kind == Frame::SourceValue )
+		{
+			d->removePending( it );
+
+			++d->m_droppedCount;
+
+			return true;
+		}
+	}
+
+	return false;
+}
+
+void
+Connection::slotBytesWritten( qint64 bytes )
+{
+	d->m_requestedBytes = qMax( d->m_requestedBytes - bytes, qint64( 0 ) );
+
+	while( !d->m_pending.empty() &&
+		canWrite( d->m_pending.front().m_data.data().size() ) )
+	{
+		collectFrame( d->m_pending.front() );
+
+		d->removePending( d->m_pending.begin() );
+	}
+
+	writeFrames();
+}
+
+void
+Connection::collectFrame( const Frame & frame, bool isRequested )
+{
+	QByteArray data = encodeDelta( frame );
+
+	// Frame is the same for all clients.
+	const bool isShared = data.isEmpty();
+
+	if( d->m_writeVersion == Protocol::Version1 )
+	{
+		// Shared frame is converted once for all clients.
+		data = ( isShared ? frame.m_data.version1() :
+			Protocol::toVersion1( data ) );
+
+		// Too large for the protocol #1.
+		if( data.isEmpty() )
+		{
+			++d->m_droppedCount;
+
+			return;
+		}
+	}
+	else if( isShared )
+		data = frame.m_data.data();
+
+	if( d->m_outgoing.isEmpty() && d->m_chunk.isEmpty() )
+		d->m_writeTimer->start( d->m_maxWriteDelay );
+
+	if( isRequested )
+		d->m_requestedBytes += data.size();
+
+	if( d->m_compressionThreshold > 0 &&
+		d->m_peerCapabilities.testFlag( ClientSocket::CompressionCapability ) )
+	{
+		// Large shared frame, a part of the list of sources for
+		// example, is compressed once for all clients.
+		if( isShared && data.size() >= d->m_compressionThreshold )
+		{
+			const QByteArray & compressed =
+				frame.m_data.compressed( d->m_writeVersion );
+
+			if( !compressed.isEmpty() )
+			{
+				flushChunk();
+
+				d->m_outgoing.append( compressed );
+
+				return;
+			}
+		}
+
+		if( !d->m_chunk.isEmpty() &&
+			d->m_chunk.size() + data.size() > c_maxChunkSize )
+				flushChunk();
+
+		d->m_chunk.append( data );
+	}
+	else if( d->m_outgoing.isEmpty() )
+		d->m_outgoing = data;
+	else
+		d->m_outgoing.append( data );
+}
+
+void
+Connection::flushChunk()
+{
+	if( d->m_chunk.isEmpty() )
+		return;
+
+	if( d->m_chunk.size() >= d->m_compressionThreshold )
+	{
+		const QByteArray compressed =
+			Protocol::compressMessages( d->m_chunk, d->m_writeVersion );
+
+		if( !compressed.isEmpty() )
+		{
+			d->m_outgoing.append( compressed );
+
+			d->m_chunk.clear();
+
+			return;
+		}
+	}
+
+	d->m_outgoing.append( d->m_chunk );
+
+	d->m_chunk.clear();
+}
+
+QByteArray
+Connection::encodeDelta( const Frame & frame )
+{
+	if( !frame.isCompact() ||
+		!d->m_peerCapabilities.testFlag( ClientSocket::ValueDeltasCapability ) )
+			return QByteArray();
+
+	switch( frame.m_kind )
+	{
+		case Frame::SourceValue :
+		{
+			const auto it = d->m_sentValues.find( frame.m_id );
+
+			if( it != d->m_sentValues.end() &&
+				SourceDeltaMessage::canEncode( it.value(), frame.m_value ) )
+			{
+				SourceDeltaMessage msg( frame.m_id, frame.m_dateTime,
+					SourceDeltaMessage::encode( it.value(), frame.m_value ) );
+
+				it.value() = frame.m_value;
+
+				return *Protocol::writeMessage( msg );
+			}
+
+			d->m_sentValues.insert( frame.m_id, frame.m_value );
+		} break;
+
+		case Frame::SourceInit :
+			d->m_sentValues.insert( frame.m_id, frame.m_value );
+		break;
+
+		case Frame::SourceDeinit :
+			d->m_sentValues.remove( frame.m_id );
+		break;
+
+		default :
+			break;
+	}
+
+	return QByteArray();
+}
+
+} /* namespace Como */
@@ -0,0 +1,237 @@
+
+/*!
+	\file
+
+	\author Igor Mironchik (igor.mironchik at gmail dot com).
+
+	Copyright (c) 2012 Igor Mironchik
+
+	Permission is hereby granted, free of charge, to any person
+	obtaining a copy of this software and associated documentation
+	files (the "Software"), to deal in the Software without
+	restriction, including without limitation the rights to use,
+	copy, modify, merge, publish, distribute, sublicense, and/or sell
+	copies of the Software, and to permit persons to whom the
+	Software is furnished to do so, subject to the following
+	conditions:
+
+	The above copyright notice and this permission notice shall be
+	included in all copies or substantial portions of the Software.
+
+	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+	EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+	OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+	NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+	HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+	WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+	FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+	OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#ifndef COMO__CONNECTION_HPP__INCLUDED
+#define COMO__CONNECTION_HPP__INCLUDED
+
+// Como include.
+#include <Como/ClientSocket>
+#include <Como/private/Protocol>
+
+// Qt include.
+#include <QObject>
+#include <QScopedPointer>
+#include <QStringList>
+
+
+QT_BEGIN_NAMESPACE
+class QIODevice;
+QT_END_NAMESPACE
+
+
+namespace Como {
+
+class Source;
+struct Frame;
+class Message;
+class SequenceMessage;
+class CompressedMessage;
+
+
+//
+// Connection
+//
+
+/*!
+	Connection with the remote side over the stream device.
+
+	This class implements the protocol for ClientSocket and
+	LocalClientSocket: reading of the messages, collecting and
+	writing of the frames, the pending queue with slow client
+	policies and deltas of the values. Connection is a child
+	of its device.
+*/
+class Connection
+	:	public QObject
+	,	private MessageVisitor
+{
+	Q_OBJECT
+
+signals:
+	//! Source has updated his value.
+	void sourceHasUpdatedValue( const Como::Source & );
+	//! GetListOfSourcesMessage request received
+	void getListOfSourcesMessageReceived();
+	//! De-initialization of the source.
+	void sourceDeinitialized( const Como::Source & );
+	//! Remote side subscribed to the sources with the given patterns.
+	void subscribeMessageReceived( const QStringList & patterns );
+	//! Remote side unsubscribed from the sources with the given patterns.
+	void unsubscribeMessageReceived( const QStringList & patterns );
+	//! Remote side asked for the updates missed since the given sequence.
+	void resumeMessageReceived( quint64 session, quint64 sequence );
+	//! Device was disconnected.
+	void disconnected();
+
+public:
+	explicit Connection( QIODevice * device );
+	~Connection();
+
+	//! \return Device of the connection.
+	QIODevice * device() const;
+
+	/*!
+		Reset state of the previous connection of the device.
+		Received sources and the sequence number are kept
+		to resume the session.
+	*/
+	void reset();
+
+	//! Send already serialized message.
+	void sendFrame( const Frame & frame );
+	/*!
+		Send already serialized message requested by the remote
+		side, list of sources or replayed updates. Such messages
+		don't count against maxBytesToWrite() and slow client
+		policy isn't applied to them.
+	*/
+	void sendRequestedFrame( const Frame & frame );
+
+	//! \return Maximum delay in milliseconds of the message before writing.
+	int maxWriteDelay() const;
+	//! Set maximum delay in milliseconds of the message before writing.
+	void setMaxWriteDelay( int msec );
+
+	//! \return Policy applied when the client is too slow.
+	ClientSocket::SlowClientPolicy slowClientPolicy() const;
+	//! Set policy applied when the client is too slow.
+	void setSlowClientPolicy( ClientSocket::SlowClientPolicy policy );
+
+	//! \return Maximum count of bytes waiting to be written.
+	qint64 maxBytesToWrite() const;
+	//! Set maximum count of bytes waiting to be written.
+	void setMaxBytesToWrite( qint64 bytes );
+
+	//! \return Maximum count of messages in the pending queue.
+	int maxPendingMessages() const;
+	//! Set maximum count of messages in the pending queue.
+	void setMaxPendingMessages( int count );
+
+	//! \return Count of values replaced by the newer value of the same source.
+	quint64 conflatedMessagesCount() const;
+	//! \return Count of dropped values.
+	quint64 droppedMessagesCount() const;
+	//! \return Was the client disconnected because it was too slow?
+	bool isDisconnectedAsSlow() const;
+
+	//! \return Capabilities of the remote side.
+	ClientSocket::Capabilities peerCapabilities() const;
+
+	//! \return Are values of the sources sent with numeric ids only?
+	bool isSourceIdsEnabled() const;
+	//! Enable sending of values of the sources with numeric ids only.
+	void setSourceIdsEnabled( bool on );
+
+	//! \return Minimum size of the collected frames to be compressed.
+	int compressionThreshold() const;
+	//! Set minimum size of the collected frames to be compressed.
+	void setCompressionThreshold( int bytes );
+
+	//! \return Sequence number of the last update received from the remote side.
+	quint64 lastSequence() const;
+
+public slots:
+	//! Send information about source.
+	void sendSourceMessage( const Como::Source & source );
+	//! Send request to receive all available sources.
+	void sendGetListOfSourcesMessage();
+	//! Send request to receive updates missed since lastSequence().
+	void sendResumeMessage();
+	//! Send information about de-initialization of the source.
+	void sendDeinitSourceMessage( const Como::Source & source );
+	//! Subscribe to the sources with the given patterns.
+	void sendSubscribeMessage( const QStringList & patterns );
+	//! Unsubscribe from the sources with the given patterns.
+	void sendUnsubscribeMessage( const QStringList & patterns );
+	//! Write all collected messages right now.
+	void writeFrames();
+	/*!
+		Send the preface of the protocol #2, all later messages
+		are written in the protocol #2. Client sends it when
+		connected, server replies with it to such clients.
+	*/
+	void sendPreface();
+
+private:
+	//! \return Capabilities of this side sent to the remote side.
+	static quint32 capabilities();
+	//! Handle received message.
+	virtual void visit( const Message & msg );
+	//! Handle received CompressedMessage.
+	void handleCompressedMessage( const CompressedMessage & msg );
+	//! Handle received SequenceMessage.
+	void handleSequenceMessage( const SequenceMessage & msg );
+	//! Handle errors in read message.
+	void handleErrorInReadMessage();
+	//! Abort the device.
+	void abortDevice();
+	//! Send message, requested by the remote side if isRequested.
+	void sendFrame( const Frame & frame, bool isRequested );
+	/*!
+		\return Can the given count of bytes be written now? Bytes
+		waiting in the device and collected for the next write
+		are counted, except bytes of the requested frames.
+	*/
+	bool canWrite( int bytes ) const;
+	//! Collect frame to be written with the next write.
+	void collectFrame( const Frame & frame, bool isRequested = false );
+	//! Move frames collected to be compressed to the outgoing data.
+	void flushChunk();
+	/*!
+		\return Delta of the value to be written instead of the frame,
+		empty if data of the frame is written. Values of the numeric
+		sources are encoded as deltas against the previous values
+		written to the remote side if it supports ValueDeltasCapability.
+	*/
+	QByteArray encodeDelta( const Frame & frame );
+	/*!
+		Put frame to the pending queue applying slow client policy.
+		Requested frames are never a reason to disconnect the client.
+	*/
+	void queueFrame( const Frame & frame, bool isRequested = false );
+	//! Drop the oldest pending value. \return false if there is no one.
+	bool dropOldestPendingValue();
+
+private slots:
+	//! New data available.
+	void slotReadyRead();
+	//! Data was written, write pending frames.
+	void slotBytesWritten( qint64 bytes );
+
+private:
+	Q_DISABLE_COPY( Connection )
+
+	struct ConnectionPrivate;
+	QScopedPointer< ConnectionPrivate > d;
+}; // class Connection
+
+} /* namespace Como */
+
+#endif // COMO__CONNECTION_HPP__INCLUDED
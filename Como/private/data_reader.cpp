@@ -0,0 +1,317 @@
+
+/*!
+	\file
+
+	\author Igor Mironchik (igor.mironchik at gmail dot com).
+
+	Copyright (c) 2012 Igor Mironchik
+
+	Permission is hereby granted, free of charge, to any person
+	obtaining a copy of this software and associated documentation
+	files (the "Software"), to deal in the Software without
+	restriction, including without limitation the rights to use,
+	copy, modify, merge, publish, distribute, sublicense, and/or sell
+	copies of the Software, and to permit persons to whom the
+	Software is furnished to do so, subject to the following
+	conditions:
+
+	The above copyright notice and this permission notice shall be
+	included in all copies or substantial portions of the Software.
+
+	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+	EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+	OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+	NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+	HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+	WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+	FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+	OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+// Como include.
+#include <Como/private/DataReader>
+
+// Qt include.
+#include <QString>
+#include <QStringList>
+#include <QDateTime>
+#include <QTimeZone>
+#include <QVariant>
+#include <QDataStream>
+
+// C++ include.
+#include <cstring>
+
+
+namespace Como {
+
+//
+// DataReader
+//
+
+//! Length of the null string.
+static const quint32 c_nullStringLength = 0xFFFFFFFF;
+
+//! Milliseconds of the null time.
+static const quint32 c_nullTime = 0xFFFFFFFF;
+
+//! Values of QDateTimePrivate::Spec written with Qt_4_0.
+enum Qt4TimeSpec {
+	Qt4UTC = 2,
+	Qt4OffsetFromUTC = 3
+}; // enum Qt4TimeSpec
+
+DataReader &
+DataReader::operator >> ( double & value )
+{
+	quint64 bits = 0;
+
+	readInteger( bits );
+
+	std::memcpy( &value, &bits, sizeof( double ) );
+
+	return *this;
+}
+
+DataReader &
+DataReader::operator >> ( QString & value )
+{
+	quint32 length = 0;
+
+	readInteger( length );
+
+	if( !m_isOk )
+		value = QString();
+	else if( length == c_nullStringLength )
+		value = QString();
+	else if( length & 0x1 )
+	{
+		m_isOk = false;
+
+		value = QString();
+	}
+	else if( length == 0 )
+		value = QLatin1String( "" );
+	else
+	{
+		const char * bytes = take( length );
+
+		if( !bytes )
+			value = QString();
+		else
+		{
+			value = QString( length / 2, Qt::Uninitialized );
+
+			qFromBigEndian< char16_t > ( bytes, length / 2, value.data() );
+		}
+	}
+
+	return *this;
+}
+
+DataReader &
+DataReader::operator >> ( QStringList & value )
+{
+	value.clear();
+
+	quint32 count = 0;
+
+	readInteger( count );
+
+	// Each string takes at least 4 bytes, don't reserve for garbage.
+	if( !m_isOk || count > ( m_data.size() - m_pos ) / 4 )
+	{
+		m_isOk = false;
+
+		return *this;
+	}
+
+	value.reserve( count );
+
+	for( quint32 i = 0; i < count && m_isOk; ++i )
+	{
+		QString str;
+
+		*this >> str;
+
+		value.append( str );
+	}
+
+	return *this;
+}
+
+DataReader &
+DataReader::operator >> ( QDate & value )
+{
+	quint32 jd = 0;
+
+	readInteger( jd );
+
+	// Qt 4 considers 0 an invalid julian day.
+	value = ( jd != 0 ? QDate::fromJulianDay( jd ) : QDate() );
+
+	return *this;
+}
+
+DataReader &
+DataReader::operator >> ( QTime & value )
+{
+	quint32 msecs = 0;
+
+	readInteger( msecs );
+
+	value = ( m_isOk && msecs != c_nullTime ?
+		QTime::fromMSecsSinceStartOfDay( msecs ) : QTime() );
+
+	return *this;
+}
+
+DataReader &
+DataReader::operator >> ( QDateTime & value )
+{
+	QDate date;
+	QTime time;
+	qint8 spec = 0;
+
+	*this >> date >> time >> spec;
+
+	if( !m_isOk )
+		value = QDateTime();
+	else if( spec == Qt4UTC || spec == Qt4OffsetFromUTC )
+		value = QDateTime( date, time, QTimeZone::utc() );
+	else
+		value = QDateTime( date, time );
+
+	return *this;
+}
+
+DataReader &
+DataReader::operator >> ( QVariant & value )
+{
+	const qsizetype start = m_pos;
+
+	quint32 typeId = 0;
+
+	readInteger( typeId );
+
+	if( !m_isOk )
+	{
+		value = QVariant();
+
+		return *this;
+	}
+
+	switch( typeId )
+	{
+		case QMetaType::Bool :
+		{
+			bool v = false;
+			*this >> v;
+			value = v;
+
+			break;
+		}
+
+		case QMetaType::Int :
+		{
+			qint32 v = 0;
+			*this >> v;
+			value = (int) v;
+
+			break;
+		}
+
+		case QMetaType::UInt :
+		{
+			quint32 v = 0;
+			*this >> v;
+			value = (uint) v;
+
+			break;
+		}
+
+		case QMetaType::LongLong :
+		{
+			qint64 v = 0;
+			*this >> v;
+			value = (qlonglong) v;
+
+			break;
+		}
+
+		case QMetaType::ULongLong :
+		{
+			quint64 v = 0;
+			*this >> v;
+			value = (qulonglong) v;
+
+			break;
+		}
+
+		case QMetaType::Double :
+		{
+			double v = 0.0;
+			*this >> v;
+			value = v;
+
+			break;
+		}
+
+		case QMetaType::QString :
+		{
+			QString v;
+			*this >> v;
+			value = v;
+
+			break;
+		}
+
+		case QMetaType::QTime :
+		{
+			QTime v;
+			*this >> v;
+			value = v;
+
+			break;
+		}
+
+		case QMetaType::QDateTime :
+		{
+			QDateTime v;
+			*this >> v;
+			value = v;
+
+			break;
+		}
+
+		default :
+		{
+			// Rare types are read by QDataStream, still without copying.
+			const QByteArray data = QByteArray::fromRawData(
+				m_data.data() + start, m_data.size() - start );
+
+			QDataStream stream( data );
+			stream.setVersion( QDataStream::Qt_4_0 );
+
+			stream >> value;
+
+			if( stream.status() != QDataStream::Ok )
+			{
+				m_isOk = false;
+
+				value = QVariant();
+			}
+			else
+				m_pos = start + stream.device()->pos();
+
+			break;
+		}
+	}
+
+	if( !m_isOk )
+		value = QVariant();
+
+	return *this;
+}
+
+} /* namespace Como */
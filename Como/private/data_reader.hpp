@@ -0,0 +1,282 @@
+
+/*!
+	\file
+
+	\author Igor Mironchik (igor.mironchik at gmail dot com).
+
+	Copyright (c) 2012 Igor Mironchik
+
+	Permission is hereby granted, free of charge, to any person
+	obtaining a copy of this software and associated documentation
+	files (the "Software"), to deal in the Software without
+	restriction, including without limitation the rights to use,
+	copy, modify, merge, publish, distribute, sublicense, and/or sell
+	copies of the Software, and to permit persons to whom the
+	Software is furnished to do so, subject to the following
+	conditions:
+
+	The above copyright notice and this permission notice shall be
+	included in all copies or substantial portions of the Software.
+
+	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+	EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+	OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+	NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+	HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+	WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+	FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+	OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#ifndef COMO__DATA_READER_HPP__INCLUDED
+#define COMO__DATA_READER_HPP__INCLUDED
+
+// Qt include.
+#include <QByteArrayView>
+#include <QStringList>
+#include <QtEndian>
+
+QT_BEGIN_NAMESPACE
+class QDate;
+class QTime;
+class QDateTime;
+class QVariant;
+QT_END_NAMESPACE
+
+
+namespace Como {
+
+//
+// DataReader
+//
+
+/*!
+	Reader of the data written by QDataStream with version Qt_4_0.
+
+	Reads directly from the given view without copying and without
+	QIODevice, so data must stay alive while reader is used.
+	After the first error all reads do nothing and isOk() returns false.
+*/
+class DataReader {
+public:
+	explicit DataReader( QByteArrayView data );
+
+	//! \return Were all reads successful?
+	bool isOk() const;
+
+	//! \return Is all data read?
+	bool atEnd() const;
+
+	//! \return Count of bytes read.
+	qsizetype position() const;
+
+	//! \return Data not read yet.
+	QByteArrayView remaining() const;
+
+	DataReader & operator >> ( bool & value );
+	DataReader & operator >> ( qint8 & value );
+	DataReader & operator >> ( quint8 & value );
+	DataReader & operator >> ( quint16 & value );
+	DataReader & operator >> ( qint32 & value );
+	DataReader & operator >> ( quint32 & value );
+	DataReader & operator >> ( qint64 & value );
+	DataReader & operator >> ( quint64 & value );
+	DataReader & operator >> ( double & value );
+	DataReader & operator >> ( QString & value );
+	DataReader & operator >> ( QStringList & value );
+	DataReader & operator >> ( QDate & value );
+	DataReader & operator >> ( QTime & value );
+	DataReader & operator >> ( QDateTime & value );
+	DataReader & operator >> ( QVariant & value );
+
+	//! Read varint, 7 bits per byte, lowest bits first.
+	DataReader & readVarint( quint64 & value );
+
+	//! \return View of the next bytes, empty on error.
+	QByteArrayView readRawData( qsizetype size );
+
+private:
+	//! \return Pointer to the next bytes and skip them, null on error.
+	const char * take( qsizetype size );
+
+	//! Read integer in big-endian byte order.
+	template< typename T >
+	DataReader & readInteger( T & value );
+
+private:
+	//! Data.
+	QByteArrayView m_data;
+	//! Current position.
+	qsizetype m_pos;
+	//! Were all reads successful?
+	bool m_isOk;
+}; // class DataReader
+
+
+inline
+DataReader::DataReader( QByteArrayView data )
+	:	m_data( data )
+	,	m_pos( 0 )
+	,	m_isOk( true )
+{
+}
+
+inline bool
+DataReader::isOk() const
+{
+	return m_isOk;
+}
+
+inline bool
+DataReader::atEnd() const
+{
+	return ( m_pos == m_data.size() );
+}
+
+inline qsizetype
+DataReader::position() const
+{
+	return m_pos;
+}
+
+inline QByteArrayView
+DataReader::remaining() const
+{
+	return m_data.sliced( m_pos );
+}
+
+inline const char *
+DataReader::take( qsizetype size )
+{
+	if( !m_isOk || m_data.size() - m_pos < size )
+	{
+		m_isOk = false;
+
+		return 0;
+	}
+
+	const char * bytes = m_data.data() + m_pos;
+
+	m_pos += size;
+
+	return bytes;
+}
+
+template< typename T >
+inline DataReader &
+DataReader::readInteger( T & value )
+{
+	const char * bytes = take( sizeof( T ) );
+
+	value = ( bytes ? qFromBigEndian< T > ( bytes ) : 0 );
+
+	return *this;
+}
+
+inline DataReader &
+DataReader::operator >> ( qint8 & value )
+{
+	const char * bytes = take( 1 );
+
+	value = ( bytes ? (qint8) *bytes : 0 );
+
+	return *this;
+}
+
+inline DataReader &
+DataReader::operator >> ( quint8 & value )
+{
+	const char * bytes = take( 1 );
+
+	value = ( bytes ? (quint8) *bytes : 0 );
+
+	return *this;
+}
+
+inline DataReader &
+DataReader::operator >> ( quint16 & value )
+{
+	return readInteger( value );
+}
+
+inline DataReader &
+DataReader::operator >> ( qint32 & value )
+{
+	return readInteger( value );
+}
+
+inline DataReader &
+DataReader::operator >> ( quint32 & value )
+{
+	return readInteger( value );
+}
+
+inline DataReader &
+DataReader::operator >> ( qint64 & value )
+{
+	return readInteger( value );
+}
+
+inline DataReader &
+DataReader::operator >> ( quint64 & value )
+{
+	return readInteger( value );
+}
+
+inline DataReader &
+DataReader::operator >> ( bool & value )
+{
+	qint8 byte = 0;
+
+	*this >> byte;
+
+	value = ( byte != 0 );
+
+	return *this;
+}
+
+inline DataReader &
+DataReader::readVarint( quint64 & value )
+{
+	value = 0;
+
+	for( int shift = 0; shift < 64; shift += 7 )
+	{
+		quint8 byte = 0;
+
+		*this >> byte;
+
+		value |= (quint64) ( byte & 0x7F ) << shift;
+
+		if( !( byte & 0x80 ) )
+			return *this;
+	}
+
+	// Too long.
+	m_isOk = false;
+	value = 0;
+
+	return *this;
+}
+
+inline QByteArrayView
+DataReader::readRawData( qsizetype size )
+{
+	if( size == 0 && m_isOk )
+		return QByteArrayView();
+
+	const char * bytes = ( size > 0 ? take( size ) : 0 );
+
+	if( !bytes )
+	{
+		m_isOk = false;
+
+		return QByteArrayView();
+	}
+
+	return QByteArrayView( bytes, size );
+}
+
+} /* namespace Como */
+
+#endif // COMO__DATA_READER_HPP__INCLUDED
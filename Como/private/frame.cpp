@@ -0,0 +1,160 @@
+
+/*!
+	\file
+
+	\author Igor Mironchik (igor.mironchik at gmail dot com).
+
+	Copyright (c) 2012 Igor Mironchik
+
+	Permission is hereby granted, free of charge, to any person
+	obtaining a copy of this software and associated documentation
+	files (the "Software"), to deal in the Software without
+	restriction, including without limitation the rights to use,
+	copy, modify, merge, publish, distribute, sublicense, and/or sell
+	copies of the Software, and to permit persons to whom the
+	Software is furnished to do so, subject to the following
+	conditions:
+
+	The above copyright notice and this permission notice shall be
+	included in all copies or substantial portions of the Software.
+
+	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+	EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+	OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+	NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+	HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+	WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+	FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+	OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+// Como include.
+#include <Como/private/Frame>
+
+// C++ include.
+#include <mutex>
+
+
+namespace Como {
+
+//
+// FramePayload::FramePayloadPrivate
+//
+
+struct FramePayload::FramePayloadPrivate {
+	explicit FramePayloadPrivate( const QByteArray & data )
+		:	m_data( data )
+	{
+		// Already serialized.
+		std::call_once( m_dataFlag, [] () {} );
+	}
+
+	explicit FramePayloadPrivate( const std::function< QByteArray () > & serialize )
+		:	m_serialize( serialize )
+	{
+	}
+
+	//! Serialize message if it's not serialized yet.
+	const QByteArray & data()
+	{
+		std::call_once( m_dataFlag, [ this ] () {
+			m_data = m_serialize();
+			m_serialize = std::function< QByteArray () > ();
+		} );
+
+		return m_data;
+	}
+
+	//! Convert message to the protocol #1 if it's not converted yet.
+	const QByteArray & version1()
+	{
+		std::call_once( m_version1Flag, [ this ] () {
+			m_version1 = Protocol::toVersion1( data() ); } );
+
+		return m_version1;
+	}
+
+	//! Compress message if it's not compressed yet.
+	const QByteArray & compressed( Protocol::Version version )
+	{
+		const int index = ( version == Protocol::Version1 ? 0 : 1 );
+
+		std::call_once( m_compressedFlags[ index ], [ this, version, index ] () {
+			const QByteArray & messages = ( version == Protocol::Version1 ?
+				version1() : data() );
+
+			if( !messages.isEmpty() )
+				m_compressed[ index ] =
+					Protocol::compressMessages( messages, version );
+		} );
+
+		return m_compressed[ index ];
+	}
+
+	//! Is message serialized?
+	std::once_flag m_dataFlag;
+	//! Function serializing the message.
+	std::function< QByteArray () > m_serialize;
+	//! Serialized message.
+	QByteArray m_data;
+	//! Is message converted to the protocol #1?
+	std::once_flag m_version1Flag;
+	//! Message in the protocol #1.
+	QByteArray m_version1;
+	//! Is message compressed, for the protocol #1 and #2?
+	std::once_flag m_compressedFlags[ 2 ];
+	//! Compressed message for the protocol #1 and #2.
+	QByteArray m_compressed[ 2 ];
+}; // struct FramePayload::FramePayloadPrivate
+
+
+//
+// FramePayload
+//
+
+FramePayload::FramePayload()
+{
+}
+
+FramePayload::FramePayload( const QByteArray & data )
+{
+	if( !data.isEmpty() )
+		d = QSharedPointer< FramePayloadPrivate >::create( data );
+}
+
+FramePayload::FramePayload( const std::function< QByteArray () > & serialize )
+	:	d( QSharedPointer< FramePayloadPrivate >::create( serialize ) )
+{
+}
+
+bool
+FramePayload::isEmpty() const
+{
+	return d.isNull();
+}
+
+const QByteArray &
+FramePayload::data() const
+{
+	static const QByteArray empty;
+
+	return ( d.isNull() ? empty : d->data() );
+}
+
+const QByteArray &
+FramePayload::version1() const
+{
+	static const QByteArray empty;
+
+	return ( d.isNull() ? empty : d->version1() );
+}
+
+const QByteArray &
+FramePayload::compressed( Protocol::Version version ) const
+{
+	static const QByteArray empty;
+
+	return ( d.isNull() ? empty : d->compressed( version ) );
+}
+
+} /* namespace Como */
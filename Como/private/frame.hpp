@@ -0,0 +1,172 @@
+
+/*!
+	\file
+
+	\author Igor Mironchik (igor.mironchik at gmail dot com).
+
+	Copyright (c) 2012 Igor Mironchik
+
+	Permission is hereby granted, free of charge, to any person
+	obtaining a copy of this software and associated documentation
+	files (the "Software"), to deal in the Software without
+	restriction, including without limitation the rights to use,
+	copy, modify, merge, publish, distribute, sublicense, and/or sell
+	copies of the Software, and to permit persons to whom the
+	Software is furnished to do so, subject to the following
+	conditions:
+
+	The above copyright notice and this permission notice shall be
+	included in all copies or substantial portions of the Software.
+
+	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+	EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+	OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+	NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+	HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+	WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+	FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+	OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#ifndef COMO__FRAME_HPP__INCLUDED
+#define COMO__FRAME_HPP__INCLUDED
+
+// Como include.
+#include <Como/private/SourceKey>
+#include <Como/private/Protocol>
+
+// Qt include.
+#include <QByteArray>
+#include <QDateTime>
+#include <QVariant>
+#include <QSharedPointer>
+
+// C++ include.
+#include <functional>
+
+
+namespace Como {
+
+//
+// FramePayload
+//
+
+/*!
+	Serialized message of the frame, shared by all copies of the frame.
+
+	Message can be serialized on the first use instead of when the
+	frame is built, then it's not serialized at all if no client
+	needs it. The same holds for the message in the protocol #1 and
+	the compressed message. Getters are thread-safe, so the frame
+	can be sent from many I/O threads.
+*/
+class FramePayload {
+public:
+	//! Empty payload.
+	FramePayload();
+	//! Payload with serialized message, empty if data is empty.
+	FramePayload( const QByteArray & data );
+	//! Payload serialized with the given function on the first use.
+	explicit FramePayload( const std::function< QByteArray () > & serialize );
+
+	//! \return Is payload empty?
+	bool isEmpty() const;
+	//! \return Serialized message.
+	const QByteArray & data() const;
+	/*!
+		\return Message in the protocol #1, empty if it's too large.
+		Message is converted only once for all clients.
+	*/
+	const QByteArray & version1() const;
+	/*!
+		\return Message compressed in CompressedMessage written in the
+		given version of the protocol, empty if it's not worth it.
+		Message is compressed only once for all clients.
+	*/
+	const QByteArray & compressed( Protocol::Version version ) const;
+
+private:
+	struct FramePayloadPrivate;
+
+	//! Shared data.
+	QSharedPointer< FramePayloadPrivate > d;
+}; // class FramePayload
+
+
+//
+// Frame
+//
+
+/*!
+	Serialized message ready to be sent to the client.
+
+	Data is implicitly shared, so one frame can be
+	sent to many clients without copying.
+*/
+struct Frame {
+	//! Kind of the frame.
+	enum Kind {
+		//! Initialization of the source.
+		SourceInit,
+		//! Value of the source. Such frames can be conflated or dropped.
+		SourceValue,
+		//! Deinitialization of the source.
+		SourceDeinit,
+		//! Sequence number of the sent updates.
+		Sequence,
+		//! Any other message.
+		Other
+	}; // enum Kind
+
+	Frame()
+		:	m_kind( Other )
+		,	m_id( 0 )
+	{
+	}
+
+	Frame( Kind kind, const FramePayload & data,
+		const SourceKey & key = SourceKey(),
+		const FramePayload & compactData = FramePayload() )
+		:	m_kind( kind )
+		,	m_key( key )
+		,	m_data( data )
+		,	m_compactData( compactData )
+		,	m_id( 0 )
+	{
+	}
+
+	//! \return Does the frame belong to the source?
+	bool isSourceFrame() const
+	{
+		return ( m_kind != Sequence && m_kind != Other );
+	}
+
+	//! \return Is compact message in m_data?
+	bool isCompact() const
+	{
+		return ( m_id != 0 && m_compactData.isEmpty() );
+	}
+
+	//! Kind of the frame.
+	Kind m_kind;
+	//! Key of the source.
+	SourceKey m_key;
+	//! Serialized message.
+	FramePayload m_data;
+	/*!
+		Serialized message for clients with enabled
+		source ids. If empty then m_data is sent.
+		Cleared when m_data is replaced with it.
+	*/
+	FramePayload m_compactData;
+	//! Id of the source.
+	quint32 m_id;
+	//! Date and time of the update of the source.
+	QDateTime m_dateTime;
+	//! Value of the source, used for delta encoding.
+	QVariant m_value;
+}; // struct Frame
+
+} /* namespace Como */
+
+#endif // COMO__FRAME_HPP__INCLUDED
@@ -30,10 +30,15 @@
 
 // Como include.
 #include <Como/private/Messages>
+#include <Como/private/DataReader>
 
 // Qt include.
 #include <QDataStream>
 #include <QIODevice>
+#include <QtAlgorithms>
+
+// C++ include.
+#include <cstring>
 
 
 namespace Como {
@@ -51,10 +56,21 @@ Message::~Message()
 // GetListOfSourcesMessage
 //
 
+GetListOfSourcesMessage::GetListOfSourcesMessage( quint32 capabilities )
+	:	m_capabilities( capabilities )
+{
+}
+
 GetListOfSourcesMessage::~GetListOfSourcesMessage()
 {
 }
 
+quint32
+GetListOfSourcesMessage::capabilities() const
+{
+	return m_capabilities;
+}
+
 quint16
 GetListOfSourcesMessage::type() const
 {
@@ -64,32 +80,268 @@ GetListOfSourcesMessage::type() const
 QSharedPointer< QByteArray >
 GetListOfSourcesMessage::serialize() const
 {
-	return QSharedPointer< QByteArray > ( new QByteArray );
+	QSharedPointer< QByteArray > data =
+		QSharedPointer< QByteArray > ( new QByteArray );
+
+	if( m_capabilities )
+	{
+		QDataStream dataStream( data.data(), QIODevice::WriteOnly );
+		dataStream.setVersion( QDataStream::Qt_4_0 );
+
+		dataStream << m_capabilities;
+	}
+
+	return data;
 }
 
 bool
-GetListOfSourcesMessage::deserialize( const QByteArray & data )
+GetListOfSourcesMessage::deserialize( QByteArrayView data )
 {
-	Q_UNUSED( data )
+	m_capabilities = 0;
 
-	return true;
+	if( data.isEmpty() )
+		return true;
+
+	DataReader reader( data );
+
+	reader >> m_capabilities;
+
+	return reader.isOk();
 }
 
 namespace /* anonymous */ {
 
+//
+// writeVarint
+//
+
+//! Write varint, 7 bits per byte, lowest bits first.
+void
+writeVarint( QDataStream & to, quint64 value )
+{
+	while( value >= 0x80 )
+	{
+		to << (quint8) ( ( value & 0x7F ) | 0x80 );
+		value >>= 7;
+	}
+
+	to << (quint8) value;
+} // writeVarint
+
+
+//
+// zigZag
+//
+
+//! \return Signed value as unsigned, small absolute values are small.
+quint64
+zigZag( qint64 value )
+{
+	return ( ( (quint64) value << 1 ) ^ (quint64) ( value >> 63 ) );
+} // zigZag
+
+
+//
+// unZigZag
+//
+
+//! \return Signed value from the result of zigZag().
+qint64
+unZigZag( quint64 value )
+{
+	return (qint64) ( ( value >> 1 ) ^ ( 0 - ( value & 1 ) ) );
+} // unZigZag
+
+
+//! Tag of the value written as QVariant.
+static const quint8 c_variantValue = 0;
+
+
+//
+// nativeValueType
+//
+
+//! \return Meta type of the value of the source of the given type.
+int
+nativeValueType( Source::Type type )
+{
+	switch( type )
+	{
+		case Source::String : return QMetaType::QString;
+		case Source::Int : return QMetaType::Int;
+		case Source::UInt : return QMetaType::UInt;
+		case Source::LongLong : return QMetaType::LongLong;
+		case Source::ULongLong : return QMetaType::ULongLong;
+		case Source::Double : return QMetaType::Double;
+		case Source::DateTime : return QMetaType::QDateTime;
+		case Source::Time : return QMetaType::QTime;
+
+		default :
+			return QMetaType::UnknownType;
+	}
+} // nativeValueType
+
+
+//
+// serializeValue
+//
+
+/*!
+	Write value natively by the type of the source: tag with the
+	type of the source, varints for integers, raw IEEE double,
+	milliseconds for date and time, UTF-8 for strings.
+
+	Value that doesn't match the type of the source, or invalid
+	date and time, is written as QVariant with c_variantValue tag.
+*/
+void
+serializeValue( QDataStream & to, Source::Type type, const QVariant & value )
+{
+	bool isNative = ( value.typeId() == nativeValueType( type ) );
+
+	if( type == Source::DateTime )
+		isNative = isNative && value.toDateTime().isValid();
+	else if( type == Source::Time )
+		isNative = isNative && value.toTime().isValid();
+
+	if( !isNative )
+	{
+		to << c_variantValue << value;
+
+		return;
+	}
+
+	to << (quint8) type;
+
+	switch( type )
+	{
+		case Source::String :
+		{
+			const QByteArray utf8 = value.toString().toUtf8();
+
+			writeVarint( to, utf8.size() );
+			to.writeRawData( utf8.constData(), utf8.size() );
+		} break;
+
+		case Source::Int :
+		case Source::LongLong :
+			writeVarint( to, zigZag( value.toLongLong() ) );
+		break;
+
+		case Source::UInt :
+		case Source::ULongLong :
+			writeVarint( to, value.toULongLong() );
+		break;
+
+		case Source::Double :
+			to << value.toDouble();
+		break;
+
+		case Source::DateTime :
+			to << (qint64) value.toDateTime().toMSecsSinceEpoch();
+		break;
+
+		case Source::Time :
+			writeVarint( to, value.toTime().msecsSinceStartOfDay() );
+		break;
+	}
+} // serializeValue
+
+
+//
+// deserializeValue
+//
+
+//! Read value written by serializeValue(), tag is its type.
+bool
+deserializeValue( DataReader & from, QVariant & value, quint8 & tag )
+{
+	tag = c_variantValue;
+	from >> tag;
+
+	quint64 bits = 0;
+
+	switch( tag )
+	{
+		case c_variantValue :
+			from >> value;
+		break;
+
+		case Source::String :
+		{
+			from.readVarint( bits );
+
+			const QByteArrayView utf8 = from.readRawData( (qsizetype) bits );
+
+			value = QString::fromUtf8( utf8 );
+		} break;
+
+		case Source::Int :
+			from.readVarint( bits );
+			value = (int) unZigZag( bits );
+		break;
+
+		case Source::UInt :
+			from.readVarint( bits );
+			value = (uint) bits;
+		break;
+
+		case Source::LongLong :
+			from.readVarint( bits );
+			value = (qlonglong) unZigZag( bits );
+		break;
+
+		case Source::ULongLong :
+			from.readVarint( bits );
+			value = (qulonglong) bits;
+		break;
+
+		case Source::Double :
+		{
+			double v = 0.0;
+			from >> v;
+			value = v;
+		} break;
+
+		case Source::DateTime :
+		{
+			qint64 msecs = 0;
+			from >> msecs;
+			value = QDateTime::fromMSecsSinceEpoch( msecs );
+		} break;
+
+		case Source::Time :
+			from.readVarint( bits );
+			value = QTime::fromMSecsSinceStartOfDay( (int) bits );
+		break;
+
+		default :
+			return false;
+	}
+
+	return from.isOk();
+} // deserializeValue
+
+
 //
 // serializeSource
 //
 
+//! Write source, value is written natively if isNativeValue.
 void
-serializeSource( QDataStream & to, const Source & source )
+serializeSource( QDataStream & to, const Source & source,
+	bool isNativeValue = false )
 {
 	to << (quint16) source.type();
 	to << source.name();
 	to << source.typeName();
 	to << source.dateTime();
 	to << source.description();
-	to << source.value();
+
+	if( isNativeValue )
+		serializeValue( to, source.type(), source.value() );
+	else
+		to << source.value();
 } // serializeSource
 
 
@@ -97,50 +349,63 @@ serializeSource( QDataStream & to, const Source & source )
 // deserializeSource
 //
 
+//! Read source written by serializeSource().
 bool
-deserializeSource( QDataStream & from, Source & source )
+deserializeSource( DataReader & from, Source & source,
+	bool isNativeValue = false )
 {
 	quint16 t;
 	from >> t;
-	if( from.status() != QDataStream::Ok )
+	if( !from.isOk() )
 		return false;
 
 	source.setType( (Source::Type) t );
 
 	QString name;
 	from >> name;
-	if( from.status() != QDataStream::Ok )
+	if( !from.isOk() )
 		return false;
 
 	source.setName( name );
 
 	QString typeName;
 	from >> typeName;
-	if( from.status() != QDataStream::Ok )
+	if( !from.isOk() )
 		return false;
 
 	source.setTypeName( typeName );
 
 	QDateTime dt;
 	from >> dt;
-	if( from.status() != QDataStream::Ok )
+	if( !from.isOk() )
 		return false;
 
-	source.setDateTime( dt );
-
 	QString desc;
 	from >> desc;
-	if( from.status() != QDataStream::Ok )
+	if( !from.isOk() )
 		return false;
 
 	source.setDescription( desc );
 
 	QVariant value;
-	from >> value;
-	if( from.status() != QDataStream::Ok )
-		return false;
 
+	if( isNativeValue )
+	{
+		quint8 tag = c_variantValue;
+
+		if( !deserializeValue( from, value, tag ) )
+			return false;
+	}
+	else
+	{
+		from >> value;
+		if( !from.isOk() )
+			return false;
+	}
+
+	// setValue() takes current date and time, so date and time after it.
 	source.setValue( value );
+	source.setDateTime( dt );
 
 	return true;
 } // deserializeSource
@@ -192,12 +457,11 @@ SourceMessage::serialize() const
 }
 
 bool
-SourceMessage::deserialize( const QByteArray & data )
+SourceMessage::deserialize( QByteArrayView data )
 {
-	QDataStream dataStream( data );
-	dataStream.setVersion( QDataStream::Qt_4_0 );
+	DataReader reader( data );
 
-	if( !deserializeSource( dataStream, m_source ) )
+	if( !deserializeSource( reader, m_source ) )
 		return false;
 
 	return true;
@@ -248,15 +512,827 @@ DeinitSourceMessage::serialize() const
 }
 
 bool
-DeinitSourceMessage::deserialize( const QByteArray & data )
+DeinitSourceMessage::deserialize( QByteArrayView data )
+{
+	DataReader reader( data );
+
+	if( !deserializeSource( reader, m_source ) )
+		return false;
+
+	return true;
+}
+
+
+//
+// SourcesListMessage
+//
+
+SourcesListMessage::SourcesListMessage()
+{
+}
+
+SourcesListMessage::SourcesListMessage( const QList< Source > & sources,
+	const QList< quint32 > & ids )
+	:	m_sources( sources )
+	,	m_ids( ids )
+{
+}
+
+SourcesListMessage::~SourcesListMessage()
+{
+}
+
+const QList< Source > &
+SourcesListMessage::sources() const
+{
+	return m_sources;
+}
+
+const QList< quint32 > &
+SourcesListMessage::ids() const
+{
+	return m_ids;
+}
+
+quint16
+SourcesListMessage::type() const
 {
-	QDataStream dataStream( data );
+	return messageType;
+}
+
+QSharedPointer< QByteArray >
+SourcesListMessage::serialize() const
+{
+	QSharedPointer< QByteArray > data =
+		QSharedPointer< QByteArray > ( new QByteArray );
+
+	QDataStream dataStream( data.data(), QIODevice::WriteOnly );
 	dataStream.setVersion( QDataStream::Qt_4_0 );
 
-	if( !deserializeSource( dataStream, m_source ) )
+	dataStream << (quint32) m_sources.size();
+
+	for( int i = 0; i < m_sources.size(); ++i )
+	{
+		dataStream << m_ids.value( i, 0 );
+
+		serializeSource( dataStream, m_sources.at( i ) );
+	}
+
+	return data;
+}
+
+bool
+SourcesListMessage::deserialize( QByteArrayView data )
+{
+	DataReader reader( data );
+
+	quint32 count = 0;
+	reader >> count;
+	if( !reader.isOk() )
 		return false;
 
+	m_sources.clear();
+	m_ids.clear();
+
+	for( quint32 i = 0; i < count; ++i )
+	{
+		quint32 id = 0;
+		reader >> id;
+		if( !reader.isOk() )
+			return false;
+
+		Source source;
+
+		if( !deserializeSource( reader, source ) )
+			return false;
+
+		m_ids.append( id );
+		m_sources.append( source );
+	}
+
 	return true;
 }
 
+
+//
+// SubscribeMessage
+//
+
+SubscribeMessage::SubscribeMessage()
+{
+}
+
+SubscribeMessage::SubscribeMessage( const QStringList & patterns )
+	:	m_patterns( patterns )
+{
+}
+
+SubscribeMessage::~SubscribeMessage()
+{
+}
+
+const QStringList &
+SubscribeMessage::patterns() const
+{
+	return m_patterns;
+}
+
+quint16
+SubscribeMessage::type() const
+{
+	return messageType;
+}
+
+QSharedPointer< QByteArray >
+SubscribeMessage::serialize() const
+{
+	QSharedPointer< QByteArray > data =
+		QSharedPointer< QByteArray > ( new QByteArray );
+
+	QDataStream dataStream( data.data(), QIODevice::WriteOnly );
+	dataStream.setVersion( QDataStream::Qt_4_0 );
+
+	dataStream << m_patterns;
+
+	return data;
+}
+
+bool
+SubscribeMessage::deserialize( QByteArrayView data )
+{
+	DataReader reader( data );
+
+	reader >> m_patterns;
+
+	return reader.isOk();
+}
+
+
+//
+// UnsubscribeMessage
+//
+
+UnsubscribeMessage::UnsubscribeMessage()
+{
+}
+
+UnsubscribeMessage::UnsubscribeMessage( const QStringList & patterns )
+	:	m_patterns( patterns )
+{
+}
+
+UnsubscribeMessage::~UnsubscribeMessage()
+{
+}
+
+const QStringList &
+UnsubscribeMessage::patterns() const
+{
+	return m_patterns;
+}
+
+quint16
+UnsubscribeMessage::type() const
+{
+	return messageType;
+}
+
+QSharedPointer< QByteArray >
+UnsubscribeMessage::serialize() const
+{
+	QSharedPointer< QByteArray > data =
+		QSharedPointer< QByteArray > ( new QByteArray );
+
+	QDataStream dataStream( data.data(), QIODevice::WriteOnly );
+	dataStream.setVersion( QDataStream::Qt_4_0 );
+
+	dataStream << m_patterns;
+
+	return data;
+}
+
+bool
+UnsubscribeMessage::deserialize( QByteArrayView data )
+{
+	DataReader reader( data );
+
+	reader >> m_patterns;
+
+	return reader.isOk();
+}
+
+
+//
+// InitSourceMessage
+//
+
+InitSourceMessage::InitSourceMessage()
+	:	m_id( 0 )
+{
+}
+
+InitSourceMessage::InitSourceMessage( quint32 id, const Source & s )
+	:	m_id( id )
+	,	m_source( s )
+{
+}
+
+InitSourceMessage::~InitSourceMessage()
+{
+}
+
+quint32
+InitSourceMessage::id() const
+{
+	return m_id;
+}
+
+const Source &
+InitSourceMessage::source() const
+{
+	return m_source;
+}
+
+quint16
+InitSourceMessage::type() const
+{
+	return messageType;
+}
+
+QSharedPointer< QByteArray >
+InitSourceMessage::serialize() const
+{
+	QSharedPointer< QByteArray > data =
+		QSharedPointer< QByteArray > ( new QByteArray );
+
+	QDataStream dataStream( data.data(), QIODevice::WriteOnly );
+	dataStream.setVersion( QDataStream::Qt_4_0 );
+
+	dataStream << m_id;
+
+	serializeSource( dataStream, m_source, true );
+
+	return data;
+}
+
+bool
+InitSourceMessage::deserialize( QByteArrayView data )
+{
+	DataReader reader( data );
+
+	reader >> m_id;
+	if( !reader.isOk() )
+		return false;
+
+	return deserializeSource( reader, m_source, true );
+}
+
+
+//
+// SourceValueMessage
+//
+
+SourceValueMessage::SourceValueMessage()
+	:	m_id( 0 )
+	,	m_valueType( Source::Int )
+{
+}
+
+SourceValueMessage::SourceValueMessage( quint32 id, const Source & s )
+	:	m_id( id )
+	,	m_dateTime( s.dateTime() )
+	,	m_value( s.value() )
+	,	m_valueType( s.type() )
+{
+}
+
+SourceValueMessage::~SourceValueMessage()
+{
+}
+
+quint32
+SourceValueMessage::id() const
+{
+	return m_id;
+}
+
+const QDateTime &
+SourceValueMessage::dateTime() const
+{
+	return m_dateTime;
+}
+
+const QVariant &
+SourceValueMessage::value() const
+{
+	return m_value;
+}
+
+quint16
+SourceValueMessage::type() const
+{
+	return messageType;
+}
+
+QSharedPointer< QByteArray >
+SourceValueMessage::serialize() const
+{
+	QSharedPointer< QByteArray > data =
+		QSharedPointer< QByteArray > ( new QByteArray );
+
+	QDataStream dataStream( data.data(), QIODevice::WriteOnly );
+	dataStream.setVersion( QDataStream::Qt_4_0 );
+
+	dataStream << m_id << m_dateTime;
+
+	serializeValue( dataStream, m_valueType, m_value );
+
+	return data;
+}
+
+bool
+SourceValueMessage::deserialize( QByteArrayView data )
+{
+	DataReader reader( data );
+
+	reader >> m_id >> m_dateTime;
+
+	quint8 tag = c_variantValue;
+
+	if( !reader.isOk() || !deserializeValue( reader, m_value, tag ) )
+		return false;
+
+	if( tag != c_variantValue )
+		m_valueType = (Source::Type) tag;
+
+	return true;
+}
+
+
+//
+// SourceDeltaMessage
+//
+
+namespace /* anonymous */ {
+
+//
+// integerBits
+//
+
+//! \return Bits of the integer value.
+quint64
+integerBits( const QVariant & value )
+{
+	switch( value.typeId() )
+	{
+		case QMetaType::UInt :
+		case QMetaType::ULongLong :
+			return value.toULongLong();
+
+		default :
+			return (quint64) value.toLongLong();
+	}
+} // integerBits
+
+
+//
+// doubleBits
+//
+
+//! \return IEEE-754 bits of the double value.
+quint64
+doubleBits( double value )
+{
+	quint64 bits = 0;
+	std::memcpy( &bits, &value, sizeof( double ) );
+
+	return bits;
+} // doubleBits
+
+
+//! Count of the lowest bits of the double delta with count of trailing zeros.
+static const int c_trailingZerosBits = 6;
+
+
+//
+// encodeDouble
+//
+
+/*!
+	Encode XOR of the bits of the doubles as its meaningful bits
+	shifted to the lowest bits and count of its trailing zeros in
+	the lowest c_trailingZerosBits bits, zero if values are equal.
+	Close values differ in the lowest bits of the mantissa, so
+	meaningful bits are few.
+
+	\return false if meaningful bits don't fit into the delta.
+*/
+bool
+encodeDouble( double base, double value, quint64 & delta )
+{
+	const quint64 bits = doubleBits( value ) ^ doubleBits( base );
+
+	if( bits == 0 )
+	{
+		delta = 0;
+
+		return true;
+	}
+
+	const int trailingZeros = qCountTrailingZeroBits( bits );
+	const quint64 meaningful = bits >> trailingZeros;
+
+	if( meaningful >> ( 64 - c_trailingZerosBits ) )
+		return false;
+
+	delta = ( meaningful << c_trailingZerosBits ) | trailingZeros;
+
+	return true;
+} // encodeDouble
+
+
+//
+// varintSize
+//
+
+//! \return Size of the value written as varint.
+int
+varintSize( quint64 value )
+{
+	int size = 1;
+
+	while( value >= 0x80 )
+	{
+		value >>= 7;
+		++size;
+	}
+
+	return size;
+} // varintSize
+
+} /* namespace anonymous */
+
+SourceDeltaMessage::SourceDeltaMessage()
+	:	m_id( 0 )
+	,	m_delta( 0 )
+{
+}
+
+SourceDeltaMessage::SourceDeltaMessage( quint32 id, const QDateTime & dt,
+	quint64 delta )
+	:	m_id( id )
+	,	m_dateTime( dt )
+	,	m_delta( delta )
+{
+}
+
+SourceDeltaMessage::~SourceDeltaMessage()
+{
+}
+
+quint32
+SourceDeltaMessage::id() const
+{
+	return m_id;
+}
+
+const QDateTime &
+SourceDeltaMessage::dateTime() const
+{
+	return m_dateTime;
+}
+
+quint64
+SourceDeltaMessage::delta() const
+{
+	return m_delta;
+}
+
+quint16
+SourceDeltaMessage::type() const
+{
+	return messageType;
+}
+
+QSharedPointer< QByteArray >
+SourceDeltaMessage::serialize() const
+{
+	QSharedPointer< QByteArray > data =
+		QSharedPointer< QByteArray > ( new QByteArray );
+
+	QDataStream dataStream( data.data(), QIODevice::WriteOnly );
+	dataStream.setVersion( QDataStream::Qt_4_0 );
+
+	dataStream << m_id << m_dateTime;
+
+	writeVarint( dataStream, m_delta );
+
+	return data;
+}
+
+bool
+SourceDeltaMessage::deserialize( QByteArrayView data )
+{
+	DataReader reader( data );
+
+	reader >> m_id >> m_dateTime;
+
+	reader.readVarint( m_delta );
+
+	return reader.isOk();
+}
+
+bool
+SourceDeltaMessage::canEncode( const QVariant & base, const QVariant & value )
+{
+	if( base.typeId() != value.typeId() )
+		return false;
+
+	switch( value.typeId() )
+	{
+		case QMetaType::Int :
+		case QMetaType::UInt :
+		case QMetaType::LongLong :
+		case QMetaType::ULongLong :
+			break;
+
+		case QMetaType::Double :
+		{
+			quint64 delta = 0;
+
+			// Delta is sent only if it's smaller than the raw double.
+			return ( encodeDouble( base.toDouble(), value.toDouble(), delta ) &&
+				varintSize( delta ) < (int) sizeof( double ) );
+		}
+
+		default :
+			return false;
+	}
+
+	return ( varintSize( encode( base, value ) ) < (int) sizeof( quint64 ) );
+}
+
+quint64
+SourceDeltaMessage::encode( const QVariant & base, const QVariant & value )
+{
+	if( value.typeId() == QMetaType::Double )
+	{
+		quint64 delta = 0;
+
+		encodeDouble( base.toDouble(), value.toDouble(), delta );
+
+		return delta;
+	}
+	else
+	{
+		const qint64 diff = (qint64) ( integerBits( value ) -
+			integerBits( base ) );
+
+		// Small negative and positive differences are small numbers.
+		return zigZag( diff );
+	}
+}
+
+QVariant
+SourceDeltaMessage::decode( const QVariant & base, quint64 delta )
+{
+	switch( base.typeId() )
+	{
+		case QMetaType::Double :
+		{
+			quint64 bits = doubleBits( base.toDouble() );
+
+			if( delta != 0 )
+			{
+				const int trailingZeros =
+					(int) ( delta & ( ( 1 << c_trailingZerosBits ) - 1 ) );
+
+				bits ^= ( delta >> c_trailingZerosBits ) << trailingZeros;
+			}
+
+			double v = 0.0;
+			std::memcpy( &v, &bits, sizeof( double ) );
+
+			return QVariant( v );
+		}
+
+		default :
+		{
+			const quint64 diff = (quint64) unZigZag( delta );
+			const quint64 v = integerBits( base ) + diff;
+
+			switch( base.typeId() )
+			{
+				case QMetaType::Int :
+					return QVariant( (int) v );
+
+				case QMetaType::UInt :
+					return QVariant( (uint) v );
+
+				case QMetaType::LongLong :
+					return QVariant( (qlonglong) v );
+
+				case QMetaType::ULongLong :
+					return QVariant( (qulonglong) v );
+
+				default :
+					return base;
+			}
+		}
+	}
+}
+
+//
+// ResumeMessage
+//
+
+ResumeMessage::ResumeMessage()
+	:	m_capabilities( 0 )
+	,	m_session( 0 )
+	,	m_sequence( 0 )
+{
+}
+
+ResumeMessage::ResumeMessage( quint32 capabilities, quint64 session,
+	quint64 sequence )
+	:	m_capabilities( capabilities )
+	,	m_session( session )
+	,	m_sequence( sequence )
+{
+}
+
+ResumeMessage::~ResumeMessage()
+{
+}
+
+quint32
+ResumeMessage::capabilities() const
+{
+	return m_capabilities;
+}
+
+quint64
+ResumeMessage::session() const
+{
+	return m_session;
+}
+
+quint64
+ResumeMessage::sequence() const
+{
+	return m_sequence;
+}
+
+quint16
+ResumeMessage::type() const
+{
+	return messageType;
+}
+
+QSharedPointer< QByteArray >
+ResumeMessage::serialize() const
+{
+	QSharedPointer< QByteArray > data =
+		QSharedPointer< QByteArray > ( new QByteArray );
+
+	QDataStream dataStream( data.data(), QIODevice::WriteOnly );
+	dataStream.setVersion( QDataStream::Qt_4_0 );
+
+	dataStream << m_capabilities << m_session << m_sequence;
+
+	return data;
+}
+
+bool
+ResumeMessage::deserialize( QByteArrayView data )
+{
+	DataReader reader( data );
+
+	reader >> m_capabilities >> m_session >> m_sequence;
+
+	return reader.isOk();
+}
+
+
+//
+// SequenceMessage
+//
+
+SequenceMessage::SequenceMessage()
+	:	m_session( 0 )
+	,	m_sequence( 0 )
+	,	m_kind( Updates )
+{
+}
+
+SequenceMessage::SequenceMessage( quint64 session, quint64 sequence,
+	Kind kind )
+	:	m_session( session )
+	,	m_sequence( sequence )
+	,	m_kind( kind )
+{
+}
+
+SequenceMessage::~SequenceMessage()
+{
+}
+
+quint64
+SequenceMessage::session() const
+{
+	return m_session;
+}
+
+quint64
+SequenceMessage::sequence() const
+{
+	return m_sequence;
+}
+
+SequenceMessage::Kind
+SequenceMessage::kind() const
+{
+	return m_kind;
+}
+
+quint16
+SequenceMessage::type() const
+{
+	return messageType;
+}
+
+QSharedPointer< QByteArray >
+SequenceMessage::serialize() const
+{
+	QSharedPointer< QByteArray > data =
+		QSharedPointer< QByteArray > ( new QByteArray );
+
+	QDataStream dataStream( data.data(), QIODevice::WriteOnly );
+	dataStream.setVersion( QDataStream::Qt_4_0 );
+
+	dataStream << m_session << m_sequence << (quint8) m_kind;
+
+	return data;
+}
+
+bool
+SequenceMessage::deserialize( QByteArrayView data )
+{
+	DataReader reader( data );
+
+	quint8 kind = 0;
+
+	reader >> m_session >> m_sequence >> kind;
+
+	if( kind > Resumed )
+		return false;
+
+	m_kind = static_cast< Kind > ( kind );
+
+	return reader.isOk();
+}
+
+//
+// CompressedMessage
+//
+
+CompressedMessage::CompressedMessage()
+{
+}
+
+CompressedMessage::CompressedMessage( const QByteArray & compressed )
+	:	m_compressed( compressed )
+{
+}
+
+CompressedMessage::~CompressedMessage()
+{
+}
+
+const QByteArray &
+CompressedMessage::compressed() const
+{
+	return m_compressed;
+}
+
+quint16
+CompressedMessage::type() const
+{
+	return messageType;
+}
+
+QSharedPointer< QByteArray >
+CompressedMessage::serialize() const
+{
+	return QSharedPointer< QByteArray > ( new QByteArray( m_compressed ) );
+}
+
+bool
+CompressedMessage::deserialize( QByteArrayView data )
+{
+	m_compressed = data.toByteArray();
+
+	return !m_compressed.isEmpty();
+}
+
 } /* namespace Como */
@@ -37,6 +37,9 @@
 // Qt include.
 #include <QSharedPointer>
 #include <QByteArray>
+#include <QByteArrayView>
+#include <QList>
+#include <QStringList>
 
 
 namespace Como {
@@ -57,7 +60,7 @@ public:
 	virtual QSharedPointer< QByteArray > serialize() const = 0;
 
 	//! Deserialize message.
-	virtual bool deserialize( const QByteArray & data ) = 0;
+	virtual bool deserialize( QByteArrayView data ) = 0;
 }; // class Message
 
 
@@ -68,7 +71,11 @@ public:
 /*!
 	If ServerSocket recives this type of message then
 	he send out list of all available sources. Each source
-	will send out in separate messages.
+	will send out in separate messages, or if client supports
+	BatchedSourcesList capability in SourcesListMessage messages.
+
+	Capabilities of the client are optional, older servers
+	just ignore them.
 */
 class GetListOfSourcesMessage
 	:	public Message
@@ -77,8 +84,32 @@ public:
 	//! Type of the  message.
 	static const quint16 messageType = 0x0001;
 
+	//! Capabilities of the client.
+	enum Capability {
+		//! Client accepts SourcesListMessage.
+		BatchedSourcesList = 0x00000001,
+		//! Client accepts InitSourceMessage and SourceValueMessage.
+		SourceIds = 0x00000002,
+		//! Client accepts SourceDeltaMessage.
+		ValueDeltas = 0x00000004,
+		/*!
+			Client needs only list of sources, updates are
+			received in other way, for example by multicast.
+		*/
+		SnapshotOnly = 0x00000008,
+		//! Client accepts SequenceMessage and can resume the session.
+		Sequences = 0x00000010,
+		//! Client accepts CompressedMessage.
+		Compression = 0x00000020
+	}; // enum Capability
+
+	explicit GetListOfSourcesMessage( quint32 capabilities = 0 );
+
 	virtual ~GetListOfSourcesMessage();
 
+	//! \return Capabilities of the client.
+	quint32 capabilities() const;
+
 	//! \return Code (type) of the message.
 	virtual quint16 type() const;
 
@@ -86,7 +117,11 @@ public:
 	virtual QSharedPointer< QByteArray > serialize() const;
 
 	//! Deserialize message.
-	virtual bool deserialize( const QByteArray & data );
+	virtual bool deserialize( QByteArrayView data );
+
+private:
+	//! Capabilities of the client.
+	quint32 m_capabilities;
 }; // class GetListOfSourcesMessage
 
 
@@ -121,7 +156,7 @@ public:
 	virtual QSharedPointer< QByteArray > serialize() const;
 
 	//! Deserialize message.
-	virtual bool deserialize( const QByteArray & data );
+	virtual bool deserialize( QByteArrayView data );
 
 private:
 	//! Source.
@@ -158,13 +193,465 @@ public:
 	virtual QSharedPointer< QByteArray > serialize() const;
 
 	//! Deserialize message.
-	virtual bool deserialize( const QByteArray & data );
+	virtual bool deserialize( QByteArrayView data );
 
 private:
 	//! Source.
 	Source m_source;
 }; // class DeinitSourceMessage
 
+
+//
+// SourcesListMessage
+//
+
+/*!
+	This is response to the GetListOfSourcesMessage
+	message with BatchedSourcesList capability.
+	It contains many sources in one message, each
+	source is preceded by its numeric id.
+*/
+class SourcesListMessage
+	:	public Message
+{
+public:
+	//! Type of the  message.
+	static const quint16 messageType = 0x0004;
+
+	SourcesListMessage();
+	SourcesListMessage( const QList< Source > & sources,
+		const QList< quint32 > & ids );
+
+	virtual ~SourcesListMessage();
+
+	//! \return Sources.
+	const QList< Source > & sources() const;
+
+	//! \return Ids of the sources.
+	const QList< quint32 > & ids() const;
+
+	//! \return Code (type) of the message.
+	virtual quint16 type() const;
+
+	//! Serialize message.
+	virtual QSharedPointer< QByteArray > serialize() const;
+
+	//! Deserialize message.
+	virtual bool deserialize( QByteArrayView data );
+
+private:
+	//! Sources.
+	QList< Source > m_sources;
+	//! Ids of the sources.
+	QList< quint32 > m_ids;
+}; // class SourcesListMessage
+
+
+//
+// SubscribeMessage
+//
+
+/*!
+	Client subscribes to the sources with the given names.
+
+	Pattern is an exact name of the source or a prefix of
+	the name ending with '*', for example "db.*". Until client
+	subscribes to something it receives updates of all sources.
+*/
+class SubscribeMessage
+	:	public Message
+{
+public:
+	//! Type of the  message.
+	static const quint16 messageType = 0x0005;
+
+	SubscribeMessage();
+	explicit SubscribeMessage( const QStringList & patterns );
+
+	virtual ~SubscribeMessage();
+
+	//! \return Patterns.
+	const QStringList & patterns() const;
+
+	//! \return Code (type) of the message.
+	virtual quint16 type() const;
+
+	//! Serialize message.
+	virtual QSharedPointer< QByteArray > serialize() const;
+
+	//! Deserialize message.
+	virtual bool deserialize( QByteArrayView data );
+
+private:
+	//! Patterns.
+	QStringList m_patterns;
+}; // class SubscribeMessage
+
+
+//
+// UnsubscribeMessage
+//
+
+/*!
+	Client unsubscribes from the sources with the given
+	patterns, previously sent in SubscribeMessage.
+*/
+class UnsubscribeMessage
+	:	public Message
+{
+public:
+	//! Type of the  message.
+	static const quint16 messageType = 0x0006;
+
+	UnsubscribeMessage();
+	explicit UnsubscribeMessage( const QStringList & patterns );
+
+	virtual ~UnsubscribeMessage();
+
+	//! \return Patterns.
+	const QStringList & patterns() const;
+
+	//! \return Code (type) of the message.
+	virtual quint16 type() const;
+
+	//! Serialize message.
+	virtual QSharedPointer< QByteArray > serialize() const;
+
+	//! Deserialize message.
+	virtual bool deserialize( QByteArrayView data );
+
+private:
+	//! Patterns.
+	QStringList m_patterns;
+}; // class UnsubscribeMessage
+
+
+//
+// InitSourceMessage
+//
+
+/*!
+	Announcement of the source with all its information
+	and numeric id. Later values of this source are sent
+	in SourceValueMessage with this id only.
+
+	Value is encoded natively by the type of the source, not
+	as QVariant: varints for integers, raw doubles, milliseconds
+	for date and time and UTF-8 for strings.
+
+	Sent only to clients with SourceIds capability.
+*/
+class InitSourceMessage
+	:	public Message
+{
+public:
+	//! Type of the  message.
+	static const quint16 messageType = 0x0007;
+
+	InitSourceMessage();
+	InitSourceMessage( quint32 id, const Source & s );
+
+	virtual ~InitSourceMessage();
+
+	//! \return Id of the source.
+	quint32 id() const;
+
+	//! \return Source.
+	const Source & source() const;
+
+	//! \return Code (type) of the message.
+	virtual quint16 type() const;
+
+	//! Serialize message.
+	virtual QSharedPointer< QByteArray > serialize() const;
+
+	//! Deserialize message.
+	virtual bool deserialize( QByteArrayView data );
+
+private:
+	//! Id of the source.
+	quint32 m_id;
+	//! Source.
+	Source m_source;
+}; // class InitSourceMessage
+
+
+//
+// SourceValueMessage
+//
+
+/*!
+	New value of the source previously announced
+	with InitSourceMessage. Contains only id, date
+	and time of the update and value encoded natively
+	like in InitSourceMessage.
+*/
+class SourceValueMessage
+	:	public Message
+{
+public:
+	//! Type of the  message.
+	static const quint16 messageType = 0x0008;
+
+	SourceValueMessage();
+	SourceValueMessage( quint32 id, const Source & s );
+
+	virtual ~SourceValueMessage();
+
+	//! \return Id of the source.
+	quint32 id() const;
+
+	//! \return Date and time of the update.
+	const QDateTime & dateTime() const;
+
+	//! \return Value.
+	const QVariant & value() const;
+
+	//! \return Code (type) of the message.
+	virtual quint16 type() const;
+
+	//! Serialize message.
+	virtual QSharedPointer< QByteArray > serialize() const;
+
+	//! Deserialize message.
+	virtual bool deserialize( QByteArrayView data );
+
+private:
+	//! Id of the source.
+	quint32 m_id;
+	//! Date and time of the update.
+	QDateTime m_dateTime;
+	//! Value.
+	QVariant m_value;
+	//! Type of the source, defines encoding of the value.
+	Source::Type m_valueType;
+}; // class SourceValueMessage
+
+
+//
+// SourceDeltaMessage
+//
+
+/*!
+	New value of the source as a delta against the previous
+	value sent to the client with InitSourceMessage,
+	SourceValueMessage or SourceDeltaMessage.
+
+	Integers are encoded as zig-zag varint of the difference, so
+	slowly changing integers take one or two bytes. Doubles are
+	encoded as varint of the meaningful bits of the XOR of their
+	bits with count of its trailing zeros. It's short only when
+	values share most bits of the mantissa, otherwise it's as
+	long as the double, and SourceValueMessage is sent instead:
+	delta is sent only if it's shorter than 8 bytes.
+
+	Sent only to clients with ValueDeltas capability.
+*/
+class SourceDeltaMessage
+	:	public Message
+{
+public:
+	//! Type of the  message.
+	static const quint16 messageType = 0x0009;
+
+	SourceDeltaMessage();
+	SourceDeltaMessage( quint32 id, const QDateTime & dt, quint64 delta );
+
+	virtual ~SourceDeltaMessage();
+
+	//! \return Id of the source.
+	quint32 id() const;
+
+	//! \return Date and time of the update.
+	const QDateTime & dateTime() const;
+
+	//! \return Encoded delta.
+	quint64 delta() const;
+
+	//! \return Code (type) of the message.
+	virtual quint16 type() const;
+
+	//! Serialize message.
+	virtual QSharedPointer< QByteArray > serialize() const;
+
+	//! Deserialize message.
+	virtual bool deserialize( QByteArrayView data );
+
+	/*!
+		\return Can value be encoded as delta against the base,
+		and is the delta shorter than the value itself?
+	*/
+	static bool canEncode( const QVariant & base, const QVariant & value );
+
+	//! \return Delta of the value against the base.
+	static quint64 encode( const QVariant & base, const QVariant & value );
+
+	//! \return Value restored from the base and the delta.
+	static QVariant decode( const QVariant & base, quint64 delta );
+
+private:
+	//! Id of the source.
+	quint32 m_id;
+	//! Date and time of the update.
+	QDateTime m_dateTime;
+	//! Encoded delta.
+	quint64 m_delta;
+}; // class SourceDeltaMessage
+
+//
+// ResumeMessage
+//
+
+/*!
+	Client reconnected and asks for the updates it has missed
+	since the given sequence number of the given session of
+	the server. If these updates aren't available anymore
+	then server sends list of all sources as in reply to
+	GetListOfSourcesMessage.
+
+	Capabilities are the same as in GetListOfSourcesMessage.
+*/
+class ResumeMessage
+	:	public Message
+{
+public:
+	//! Type of the  message.
+	static const quint16 messageType = 0x000A;
+
+	ResumeMessage();
+	ResumeMessage( quint32 capabilities, quint64 session, quint64 sequence );
+
+	virtual ~ResumeMessage();
+
+	//! \return Capabilities of the client.
+	quint32 capabilities() const;
+
+	//! \return Session of the server.
+	quint64 session() const;
+
+	//! \return Sequence number of the last received update.
+	quint64 sequence() const;
+
+	//! \return Code (type) of the message.
+	virtual quint16 type() const;
+
+	//! Serialize message.
+	virtual QSharedPointer< QByteArray > serialize() const;
+
+	//! Deserialize message.
+	virtual bool deserialize( QByteArrayView data );
+
+private:
+	//! Capabilities of the client.
+	quint32 m_capabilities;
+	//! Session of the server.
+	quint64 m_session;
+	//! Sequence number of the last received update.
+	quint64 m_sequence;
+}; // class ResumeMessage
+
+
+//
+// SequenceMessage
+//
+
+/*!
+	All updates up to the given sequence number of the given
+	session of the server were sent. Server sends it after
+	each portion of updates, after list of sources and after
+	the missed updates in reply to ResumeMessage.
+
+	Sent only to clients with Sequences capability.
+*/
+class SequenceMessage
+	:	public Message
+{
+public:
+	//! Type of the  message.
+	static const quint16 messageType = 0x000B;
+
+	//! What was sent before this message.
+	enum Kind {
+		//! Updates of the sources.
+		Updates = 0,
+		//! List of all sources.
+		Snapshot = 1,
+		//! Missed updates in reply to ResumeMessage.
+		Resumed = 2
+	}; // enum Kind
+
+	SequenceMessage();
+	SequenceMessage( quint64 session, quint64 sequence, Kind kind );
+
+	virtual ~SequenceMessage();
+
+	//! \return Session of the server.
+	quint64 session() const;
+
+	//! \return Sequence number of the last sent update.
+	quint64 sequence() const;
+
+	//! \return What was sent before this message.
+	Kind kind() const;
+
+	//! \return Code (type) of the message.
+	virtual quint16 type() const;
+
+	//! Serialize message.
+	virtual QSharedPointer< QByteArray > serialize() const;
+
+	//! Deserialize message.
+	virtual bool deserialize( QByteArrayView data );
+
+private:
+	//! Session of the server.
+	quint64 m_session;
+	//! Sequence number of the last sent update.
+	quint64 m_sequence;
+	//! What was sent before this message.
+	Kind m_kind;
+}; // class SequenceMessage
+
+//
+// CompressedMessage
+//
+
+/*!
+	Several messages compressed with qCompress(). Server
+	compresses collected messages if their size is not less
+	than the threshold and compressed data is smaller.
+
+	Sent only to clients with Compression capability.
+*/
+class CompressedMessage
+	:	public Message
+{
+public:
+	//! Type of the  message.
+	static const quint16 messageType = 0x000C;
+
+	CompressedMessage();
+	explicit CompressedMessage( const QByteArray & compressed );
+
+	virtual ~CompressedMessage();
+
+	//! \return Compressed messages.
+	const QByteArray & compressed() const;
+
+	//! \return Code (type) of the message.
+	virtual quint16 type() const;
+
+	//! Serialize message.
+	virtual QSharedPointer< QByteArray > serialize() const;
+
+	//! Deserialize message.
+	virtual bool deserialize( QByteArrayView data );
+
+private:
+	//! Compressed messages.
+	QByteArray m_compressed;
+}; // class CompressedMessage
+
 } /* namespace Como */
 
 #endif // COMO__MESSAGES_HPP__INCLUDED
@@ -0,0 +1,177 @@
+
+/*!
+	\file
+
+	\author Igor Mironchik (igor.mironchik at gmail dot com).
+
+	Copyright (c) 2012 Igor Mironchik
+
+	Permission is hereby granted, free of charge, to any person
+	obtaining a copy of this software and associated documentation
+	files (the "Software"), to deal in the Software without
+	restriction, including without limitation the rights to use,
+	copy, modify, merge, publish, distribute, sublicense, and/or sell
+	copies of the Software, and to permit persons to whom the
+	Software is furnished to do so, subject to the following
+	conditions:
+
+	The above copyright notice and this permission notice shall be
+	included in all copies or substantial portions of the Software.
+
+	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+	EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+	OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+	NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+	HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+	WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+	FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+	OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#ifndef COMO__MPSC_QUEUE_HPP__INCLUDED
+#define COMO__MPSC_QUEUE_HPP__INCLUDED
+
+// C++ include.
+#include <atomic>
+#include <utility>
+
+
+namespace Como {
+
+//
+// MpscQueue
+//
+
+/*!
+	Lock-free multi-producer/single-consumer queue.
+
+	push() can be invoked from any thread, pop() must be
+	invoked only from one consumer thread. Producers never
+	wait for each other or for the consumer.
+
+	This is an unbounded node-based queue by Dmitry Vyukov.
+*/
+template< typename T >
+class MpscQueue {
+public:
+	MpscQueue()
+		:	m_head( &m_stub )
+		,	m_tail( &m_stub )
+	{
+		m_stub.m_next.store( nullptr, std::memory_order_relaxed );
+	}
+
+	~MpscQueue()
+	{
+		T value;
+
+		while( pop( value ) )
+		{
+		}
+	}
+
+	//! Push value to the end of the queue.
+	void push( T value )
+	{
+		push( new Node( std::move( value ) ) );
+	}
+
+	/*!
+		Pop value from the beginning of the queue.
+
+		\return false if queue is empty. It's possible that false
+		is returned when some producer is in the middle of the push,
+		in this case pushed value will be available later.
+	*/
+	bool pop( T & value )
+	{
+		Node * tail = m_tail;
+		Node * next = tail->m_next.load( std::memory_order_acquire );
+
+		if( tail == &m_stub )
+		{
+			if( !next )
+				return false;
+
+			m_tail = next;
+			tail = next;
+			next = next->m_next.load( std::memory_order_acquire );
+		}
+
+		if( next )
+		{
+			m_tail = next;
+
+			value = std::move( tail->m_value );
+
+			delete tail;
+
+			return true;
+		}
+
+		if( tail != m_head.load( std::memory_order_acquire ) )
+			return false;
+
+		push( &m_stub );
+
+		next = tail->m_next.load( std::memory_order_acquire );
+
+		if( next )
+		{
+			m_tail = next;
+
+			value = std::move( tail->m_value );
+
+			delete tail;
+
+			return true;
+		}
+
+		return false;
+	}
+
+private:
+	//! Node of the queue.
+	struct Node {
+		Node()
+			:	m_next( nullptr )
+		{
+		}
+
+		explicit Node( T && value )
+			:	m_next( nullptr )
+			,	m_value( std::move( value ) )
+		{
+		}
+
+		//! Next node.
+		std::atomic< Node* > m_next;
+		//! Value.
+		T m_value;
+	}; // struct Node
+
+	//! Push node to the end of the queue.
+	void push( Node * node )
+	{
+		node->m_next.store( nullptr, std::memory_order_relaxed );
+
+		Node * prev = m_head.exchange( node, std::memory_order_acq_rel );
+
+		prev->m_next.store( node, std::memory_order_release );
+	}
+
+private:
+	MpscQueue( const MpscQueue & );
+	MpscQueue & operator = ( const MpscQueue & );
+
+	//! Stub node.
+	Node m_stub;
+	//! Last pushed node, is modified by producers.
+	std::atomic< Node* > m_head;
+	//! First node, is modified by consumer only.
+	Node * m_tail;
+}; // class MpscQueue
+
+} /* namespace Como */
+
+#endif // COMO__MPSC_QUEUE_HPP__INCLUDED
@@ -0,0 +1,105 @@
+
+/*!
+	\file
+
+	\author Igor Mironchik (igor.mironchik at gmail dot com).
+
+	Copyright (c) 2012 Igor Mironchik
+
+	Permission is hereby granted, free of charge, to any person
+	obtaining a copy of this software and associated documentation
+	files (the "Software"), to deal in the Software without
+	restriction, including without limitation the rights to use,
+	copy, modify, merge, publish, distribute, sublicense, and/or sell
+	copies of the Software, and to permit persons to whom the
+	Software is furnished to do so, subject to the following
+	conditions:
+
+	The above copyright notice and this permission notice shall be
+	included in all copies or substantial portions of the Software.
+
+	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+	EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+	OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+	NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+	HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+	WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+	FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+	OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#ifndef COMO__MULTICAST_DATAGRAM_HPP__INCLUDED
+#define COMO__MULTICAST_DATAGRAM_HPP__INCLUDED
+
+// Qt include.
+#include <QByteArray>
+#include <QDataStream>
+#include <QIODevice>
+
+
+namespace Como {
+
+//
+// MulticastDatagram
+//
+
+/*!
+	Format of the multicast datagram.
+
+	Datagram starts with the magic number and the sequence
+	number of the datagram, followed by one or more messages
+	of the Como protocol. Client that sees gap in the sequence
+	numbers requests list of sources over TCP.
+*/
+struct MulticastDatagram {
+	//! Magic number of the datagram, "COMOMCA1".
+	static const quint64 c_magicNumber = 0x434F4D4F4D434131;
+
+	/*!
+		Size of the header. 16 bytes.
+
+		8 bytes of magic number +
+		8 bytes of sequence number.
+	*/
+	static const int c_headerSize = 16;
+
+	/*!
+		Maximum size of the datagram with many messages,
+		fits in the Ethernet MTU. Larger messages are sent
+		in separate datagrams.
+	*/
+	static const int c_maxSize = 1400;
+
+	//! \return Header of the datagram with the given sequence number.
+	static QByteArray header( quint64 sequence )
+	{
+		QByteArray data;
+
+		QDataStream stream( &data, QIODevice::WriteOnly );
+		stream.setVersion( QDataStream::Qt_4_0 );
+
+		stream << c_magicNumber << sequence;
+
+		return data;
+	}
+
+	//! Read header of the datagram. \return false if it's not our datagram.
+	static bool readHeader( const QByteArray & datagram, quint64 & sequence )
+	{
+		if( datagram.size() < c_headerSize )
+			return false;
+
+		QDataStream stream( datagram );
+		stream.setVersion( QDataStream::Qt_4_0 );
+
+		quint64 magicNumber = 0;
+
+		stream >> magicNumber >> sequence;
+
+		return ( magicNumber == c_magicNumber );
+	}
+}; // struct MulticastDatagram
+
+} /* namespace Como */
+
+#endif // COMO__MULTICAST_DATAGRAM_HPP__INCLUDED
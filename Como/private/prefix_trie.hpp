@@ -0,0 +1,225 @@
+
+/*!
+	\file
+
+	\author Igor Mironchik (igor.mironchik at gmail dot com).
+
+	Copyright (c) 2012 Igor Mironchik
+
+	Permission is hereby granted, free of charge, to any person
+	obtaining a copy of this software and associated documentation
+	files (the "Software"), to deal in the Software without
+	restriction, including without limitation the rights to use,
+	copy, modify, merge, publish, distribute, sublicense, and/or sell
+	copies of the Software, and to permit persons to whom the
+	Software is furnished to do so, subject to the following
+	conditions:
+
+	The above copyright notice and this permission notice shall be
+	included in all copies or substantial portions of the Software.
+
+	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+	EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+	OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+	NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+	HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+	WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+	FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+	OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#ifndef COMO__PREFIX_TRIE_HPP__INCLUDED
+#define COMO__PREFIX_TRIE_HPP__INCLUDED
+
+// Qt include.
+#include <QString>
+#include <QChar>
+#include <QHash>
+#include <QSet>
+#include <QVarLengthArray>
+#include <QtAlgorithms>
+
+
+namespace Como {
+
+//
+// PrefixTrie
+//
+
+/*!
+	Prefix trie of the subscriptions to the names of the sources.
+
+	Pattern is an exact name or a prefix ending with '*', '*'
+	anywhere else isn't allowed and such patterns are ignored.
+	Matching of the name costs O(length of the name) and doesn't
+	depend on the count of subscriptions.
+*/
+template< typename T >
+class PrefixTrie {
+public:
+	PrefixTrie()
+		:	m_root( new Node )
+	{
+	}
+
+	~PrefixTrie()
+	{
+		delete m_root;
+	}
+
+	//! \return Is pattern an exact name or a prefix ending with '*'?
+	static bool isValid( const QString & pattern )
+	{
+		const int index = pattern.indexOf( QLatin1Char( '*' ) );
+
+		return ( index < 0 || index == pattern.size() - 1 );
+	}
+
+	//! Subscribe value to the pattern, invalid pattern is ignored.
+	void add( const QString & pattern, const T & value )
+	{
+		if( !isValid( pattern ) )
+			return;
+
+		bool isPrefix = false;
+		const QString key = parse( pattern, isPrefix );
+
+		Node * node = m_root;
+
+		for( const QChar & ch : key )
+		{
+			Node *& child = node->m_children[ ch ];
+
+			if( !child )
+				child = new Node;
+
+			node = child;
+		}
+
+		if( isPrefix )
+			node->m_prefix.insert( value );
+		else
+			node->m_exact.insert( value );
+	}
+
+	//! Unsubscribe value from the pattern.
+	void remove( const QString & pattern, const T & value )
+	{
+		if( !isValid( pattern ) )
+			return;
+
+		bool isPrefix = false;
+		const QString key = parse( pattern, isPrefix );
+
+		QVarLengthArray< Node*, 64 > path;
+		path.append( m_root );
+
+		Node * node = m_root;
+
+		for( const QChar & ch : key )
+		{
+			node = node->m_children.value( ch, 0 );
+
+			if( !node )
+				return;
+
+			path.append( node );
+		}
+
+		if( isPrefix )
+			node->m_prefix.remove( value );
+		else
+			node->m_exact.remove( value );
+
+		for( int i = path.size() - 1; i > 0 && path[ i ]->isEmpty(); --i )
+		{
+			path[ i - 1 ]->m_children.remove( key.at( i - 1 ) );
+
+			delete path[ i ];
+		}
+	}
+
+	//! Collect values subscribed to the given name.
+	void match( const QString & name, QSet< T > & values ) const
+	{
+		const Node * node = m_root;
+
+		values.unite( node->m_prefix );
+
+		for( const QChar & ch : name )
+		{
+			node = node->m_children.value( ch, 0 );
+
+			if( !node )
+				return;
+
+			values.unite( node->m_prefix );
+		}
+
+		values.unite( node->m_exact );
+	}
+
+	//! \return Is value subscribed to the given name?
+	bool isMatched( const QString & name, const T & value ) const
+	{
+		const Node * node = m_root;
+
+		if( node->m_prefix.contains( value ) )
+			return true;
+
+		for( const QChar & ch : name )
+		{
+			node = node->m_children.value( ch, 0 );
+
+			if( !node )
+				return false;
+
+			if( node->m_prefix.contains( value ) )
+				return true;
+		}
+
+		return node->m_exact.contains( value );
+	}
+
+private:
+	//! Node of the trie.
+	struct Node {
+		~Node()
+		{
+			qDeleteAll( m_children );
+		}
+
+		//! \return Is node not needed anymore?
+		bool isEmpty() const
+		{
+			return ( m_children.isEmpty() && m_prefix.isEmpty() &&
+				m_exact.isEmpty() );
+		}
+
+		//! Children.
+		QHash< QChar, Node* > m_children;
+		//! Values subscribed to all names with this prefix.
+		QSet< T > m_prefix;
+		//! Values subscribed to exactly this name.
+		QSet< T > m_exact;
+	}; // struct Node
+
+	//! \return Key of the valid pattern in the trie.
+	static QString parse( const QString & pattern, bool & isPrefix )
+	{
+		isPrefix = pattern.endsWith( QLatin1Char( '*' ) );
+
+		return ( isPrefix ? pattern.chopped( 1 ) : pattern );
+	}
+
+private:
+	PrefixTrie( const PrefixTrie & );
+	PrefixTrie & operator = ( const PrefixTrie & );
+
+	//! Root.
+	Node * m_root;
+}; // class PrefixTrie
+
+} /* namespace Como */
+
+#endif // COMO__PREFIX_TRIE_HPP__INCLUDED
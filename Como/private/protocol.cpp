@@ -35,6 +35,10 @@
 // Qt include.
 #include <QDataStream>
 #include <QIODevice>
+#include <QtEndian>
+
+// C++ include.
+#include <limits>
 
 
 namespace Como {
@@ -97,6 +101,9 @@ NotEnoughDataReceivedException::~NotEnoughDataReceivedException() throw()
 //! Magic number for the Como protocol #1.
 static const quint64 c_magicNumber = 0x434F4D4F50524F31;
 
+//! Magic number in the preface of the Como protocol #2.
+static const quint64 c_magicNumber2 = 0x434F4D4F50524F32;
+
 /*!
 	Message's header size. 12 bytes.
 
@@ -106,14 +113,242 @@ static const quint64 c_magicNumber = 0x434F4D4F50524F31;
 */
 static const quint8 c_headerSize = 12;
 
+//! Maximum size of the message in the protocol #2, bigger size is garbage.
+static const quint64 c_maxMessageSize = 64 * 1024 * 1024;
+
+//! Maximum size of the varint, 64 bits in 7 bits per byte.
+static const int c_maxVarintSize = 10;
+
+namespace /* anonymous */ {
+
+//
+// appendVarint
+//
+
+//! Append varint, 7 bits per byte, lowest bits first.
+void
+appendVarint( QByteArray & data, quint64 value )
+{
+	while( value >= 0x80 )
+	{
+		data.append( (char) ( ( value & 0x7F ) | 0x80 ) );
+		value >>= 7;
+	}
+
+	data.append( (char) value );
+} // appendVarint
+
+
+//
+// readVarint
+//
+
+/*!
+	Read varint at the given position and move position after it.
+
+	\return NeedMoreData if varint is incomplete, Garbage if it's
+	too long, MessageDecoded if varint is read.
+*/
+MessageDecoder::Status
+readVarint( QByteArrayView data, int & pos, quint64 & value )
+{
+	value = 0;
+
+	for( int i = 0; i < c_maxVarintSize; ++i )
+	{
+		if( pos >= data.size() )
+			return MessageDecoder::NeedMoreData;
+
+		const quint8 byte = (quint8) data.at( pos++ );
+
+		value |= (quint64) ( byte & 0x7F ) << ( 7 * i );
+
+		if( !( byte & 0x80 ) )
+			return MessageDecoder::MessageDecoded;
+	}
+
+	return MessageDecoder::Garbage;
+} // readVarint
+
+
+//
+// isMessageType
+//
+
+//! \return Is message of the given type known?
+bool
+isMessageType( quint64 messageType )
+{
+	// Types of the messages are numbered sequentially.
+	return ( messageType >= GetListOfSourcesMessage::messageType &&
+		messageType <= CompressedMessage::messageType );
+} // isMessageType
+
+
+//
+// visitMessage
+//
+
+//! Deserialize message on the stack and pass it to the visitor.
+template< class Msg >
+bool
+visitMessage( QByteArrayView data, MessageVisitor & visitor )
+{
+	Msg msg;
+
+	if( !msg.deserialize( data ) )
+		return false;
+
+	visitor.visit( msg );
+
+	return true;
+} // visitMessage
+
+
+//
+// decodeMessage
+//
+
+/*!
+	Deserialize message of the given type and pass it to the visitor.
+
+	\return false if type is unknown or data is corrupted.
+*/
+bool
+decodeMessage( quint64 messageType, QByteArrayView data,
+	MessageVisitor & visitor )
+{
+	switch( messageType )
+	{
+		case GetListOfSourcesMessage::messageType :
+			return visitMessage< GetListOfSourcesMessage > ( data, visitor );
+		case SourceMessage::messageType :
+			return visitMessage< SourceMessage > ( data, visitor );
+		case DeinitSourceMessage::messageType :
+			return visitMessage< DeinitSourceMessage > ( data, visitor );
+		case SourcesListMessage::messageType :
+			return visitMessage< SourcesListMessage > ( data, visitor );
+		case SubscribeMessage::messageType :
+			return visitMessage< SubscribeMessage > ( data, visitor );
+		case UnsubscribeMessage::messageType :
+			return visitMessage< UnsubscribeMessage > ( data, visitor );
+		case InitSourceMessage::messageType :
+			return visitMessage< InitSourceMessage > ( data, visitor );
+		case SourceValueMessage::messageType :
+			return visitMessage< SourceValueMessage > ( data, visitor );
+		case SourceDeltaMessage::messageType :
+			return visitMessage< SourceDeltaMessage > ( data, visitor );
+		case ResumeMessage::messageType :
+			return visitMessage< ResumeMessage > ( data, visitor );
+		case SequenceMessage::messageType :
+			return visitMessage< SequenceMessage > ( data, visitor );
+		case CompressedMessage::messageType :
+			return visitMessage< CompressedMessage > ( data, visitor );
+
+		default :
+			return false;
+	}
+} // decodeMessage
+
+
+//
+// copyMessage
+//
+
+//! \return Copy of the message on the heap.
+template< class Msg >
+QSharedPointer< Message >
+copyMessage( const Message & msg )
+{
+	return QSharedPointer< Message > (
+		new Msg( static_cast< const Msg& > ( msg ) ) );
+} // copyMessage
+
+
+//
+// MessageKeeper
+//
+
+//! Visitor keeping copy of the visited message.
+class MessageKeeper
+	:	public MessageVisitor
+{
+public:
+	//! Copy the message.
+	virtual void visit( const Message & msg )
+	{
+		switch( msg.type() )
+		{
+			case GetListOfSourcesMessage::messageType :
+				m_message = copyMessage< GetListOfSourcesMessage > ( msg );
+			break;
+			case SourceMessage::messageType :
+				m_message = copyMessage< SourceMessage > ( msg );
+			break;
+			case DeinitSourceMessage::messageType :
+				m_message = copyMessage< DeinitSourceMessage > ( msg );
+			break;
+			case SourcesListMessage::messageType :
+				m_message = copyMessage< SourcesListMessage > ( msg );
+			break;
+			case SubscribeMessage::messageType :
+				m_message = copyMessage< SubscribeMessage > ( msg );
+			break;
+			case UnsubscribeMessage::messageType :
+				m_message = copyMessage< UnsubscribeMessage > ( msg );
+			break;
+			case InitSourceMessage::messageType :
+				m_message = copyMessage< InitSourceMessage > ( msg );
+			break;
+			case SourceValueMessage::messageType :
+				m_message = copyMessage< SourceValueMessage > ( msg );
+			break;
+			case SourceDeltaMessage::messageType :
+				m_message = copyMessage< SourceDeltaMessage > ( msg );
+			break;
+			case ResumeMessage::messageType :
+				m_message = copyMessage< ResumeMessage > ( msg );
+			break;
+			case SequenceMessage::messageType :
+				m_message = copyMessage< SequenceMessage > ( msg );
+			break;
+			case CompressedMessage::messageType :
+				m_message = copyMessage< CompressedMessage > ( msg );
+			break;
+
+			default :
+				break;
+		}
+	}
+
+	//! Copy of the visited message.
+	QSharedPointer< Message > m_message;
+}; // class MessageKeeper
+
+} /* namespace anonymous */
+
 QSharedPointer< QByteArray >
-Protocol::writeMessage( const Message & msg )
+Protocol::writeMessage( const Message & msg, Version version )
 {
 	QSharedPointer< QByteArray > data =
 		QSharedPointer< QByteArray > ( new QByteArray );
 
 	QSharedPointer< QByteArray > msgData = msg.serialize();
 
+	if( version == Version2 )
+	{
+		data->reserve( msgData->size() + 2 * c_maxVarintSize );
+
+		appendVarint( *data, msg.type() );
+		appendVarint( *data, msgData->size() );
+		data->append( *msgData );
+
+		return data;
+	}
+
+	if( msgData->size() > std::numeric_limits< quint16 >::max() )
+		throw ProtocolException( QLatin1String( "Message is too large." ) );
+
 	QDataStream dataStream( data.data(), QIODevice::WriteOnly );
 	dataStream.setVersion( QDataStream::Qt_4_0 );
 
@@ -126,68 +361,226 @@ Protocol::writeMessage( const Message & msg )
 }
 
 QSharedPointer< Message >
-Protocol::readMessage( const QByteArray & data, int & bytesRead )
+Protocol::readMessage( QByteArrayView data, int & bytesRead,
+	Version version )
+{
+	MessageDecoder decoder( version );
+	MessageKeeper keeper;
+
+	switch( decoder.decode( data, keeper ) )
+	{
+		case MessageDecoder::MessageDecoded :
+			bytesRead = decoder.bytesRead();
+			return keeper.m_message;
+
+		case MessageDecoder::NeedMoreData :
+			throw NotEnoughDataReceivedException();
+
+		default :
+			throw GarbageReceivedException();
+	}
+}
+
+QByteArray
+Protocol::preface()
 {
-	if( data.size() < c_headerSize )
-		throw NotEnoughDataReceivedException();
+	QByteArray data;
 
-	QDataStream dataStream( data );
+	QDataStream dataStream( &data, QIODevice::WriteOnly );
 	dataStream.setVersion( QDataStream::Qt_4_0 );
 
-	quint64 magicNumber = 0;
-	quint16 messageType = 0;
-	quint16 messageLength = 0;
+	dataStream << c_magicNumber2;
 
-	dataStream >> magicNumber >> messageType >> messageLength;
+	return data;
+}
 
-	switch( messageType )
+QByteArray
+Protocol::toVersion1( const QByteArray & data )
+{
+	int pos = 0;
+	quint64 messageType = 0;
+	quint64 messageLength = 0;
+
+	if( readVarint( data, pos, messageType ) != MessageDecoder::MessageDecoded ||
+		readVarint( data, pos, messageLength ) !=
+			MessageDecoder::MessageDecoded ||
+		messageLength > std::numeric_limits< quint16 >::max() ||
+		(quint64) data.size() < pos + messageLength )
+			return QByteArray();
+
+	QByteArray result;
+	result.reserve( c_headerSize + (int) messageLength );
+
+	QDataStream dataStream( &result, QIODevice::WriteOnly );
+	dataStream.setVersion( QDataStream::Qt_4_0 );
+
+	dataStream << c_magicNumber << (quint16) messageType
+		<< (quint16) messageLength;
+	dataStream.writeRawData( data.constData() + pos, (int) messageLength );
+
+	return result;
+}
+
+QByteArray
+Protocol::compressMessages( const QByteArray & messages, Version version )
+{
+	const QByteArray compressed = qCompress( messages );
+
+	// Incompressible data is sent as is.
+	if( compressed.size() >= messages.size() ||
+		( version == Version1 &&
+			compressed.size() > std::numeric_limits< quint16 >::max() ) )
+				return QByteArray();
+
+	return *writeMessage( CompressedMessage( compressed ), version );
+}
+
+QByteArray
+Protocol::uncompressMessages( const QByteArray & compressed )
+{
+	// qCompress() prepends 4 bytes of the uncompressed size.
+	if( compressed.size() <= (int) sizeof( quint32 ) )
+		return QByteArray();
+
+	const quint32 size = qFromBigEndian< quint32 >( compressed.constData() );
+
+	if( size == 0 || size > c_maxMessageSize )
+		return QByteArray();
+
+	const QByteArray messages = qUncompress( compressed );
+
+	if( messages.size() != (qsizetype) size )
+		return QByteArray();
+
+	return messages;
+}
+
+
+//
+// MessageVisitor
+//
+
+MessageVisitor::~MessageVisitor()
+{
+}
+
+
+//
+// MessageDecoder
+//
+
+MessageDecoder::MessageDecoder( Protocol::Version version )
+	:	m_version( version )
+	,	m_headerSize( 0 )
+	,	m_messageType( 0 )
+	,	m_messageLength( 0 )
+	,	m_bytesRead( 0 )
+{
+}
+
+Protocol::Version
+MessageDecoder::version() const
+{
+	return m_version;
+}
+
+void
+MessageDecoder::reset( Protocol::Version version )
+{
+	m_version = version;
+	m_headerSize = 0;
+	m_messageType = 0;
+	m_messageLength = 0;
+	m_bytesRead = 0;
+}
+
+MessageDecoder::Status
+MessageDecoder::decode( QByteArrayView data, MessageVisitor & visitor )
+{
+	m_bytesRead = 0;
+
+	if( !m_headerSize )
 	{
-		case GetListOfSourcesMessage::messageType :
-		case SourceMessage::messageType :
-		case DeinitSourceMessage::messageType :
-			break;
+		const Status status = decodeHeader( data );
 
-		default :
-			throw GarbageReceivedException();
+		if( status != MessageDecoded )
+			return status;
 	}
 
-	if( magicNumber != c_magicNumber )
-		throw GarbageReceivedException();
+	const quint64 messageSize = m_headerSize + m_messageLength;
 
-	if( data.size() < c_headerSize + messageLength )
-		throw NotEnoughDataReceivedException();
+	if( (quint64) data.size() < messageSize )
+		return NeedMoreData;
 
-	QByteArray msgData( messageLength, 0x00 );
+	const int headerSize = m_headerSize;
 
-	dataStream.readRawData( msgData.data(), messageLength );
+	m_headerSize = 0;
 
-	bytesRead = c_headerSize + messageLength;
+	if( !decodeMessage( m_messageType,
+		data.sliced( headerSize, (qsizetype) m_messageLength ), visitor ) )
+			return Garbage;
 
-	QSharedPointer < Message > msg;
+	m_bytesRead = (int) messageSize;
 
-	switch( messageType )
+	return MessageDecoded;
+}
+
+int
+MessageDecoder::bytesRead() const
+{
+	return m_bytesRead;
+}
+
+MessageDecoder::Status
+MessageDecoder::decodeHeader( QByteArrayView data )
+{
+	int pos = 0;
+
+	if( m_version == Protocol::Version2 )
 	{
-		case GetListOfSourcesMessage::messageType :
-		{
-			msg = QSharedPointer< Message > ( new GetListOfSourcesMessage );
-		} break;
-		case SourceMessage::messageType :
-		{
-			msg = QSharedPointer< Message > ( new SourceMessage );
-		} break;
-		case DeinitSourceMessage::messageType :
+		Status status = readVarint( data, pos, m_messageType );
+
+		if( status == MessageDecoded )
+			status = readVarint( data, pos, m_messageLength );
+
+		if( status != MessageDecoded )
+			return status;
+
+		if( m_messageLength > c_maxMessageSize )
+			return Garbage;
+	}
+	else
+	{
+		if( data.size() < Protocol::prefaceSize )
+			return NeedMoreData;
+
+		const quint64 magicNumber = qFromBigEndian< quint64 > ( data.data() );
+
+		if( magicNumber == c_magicNumber2 )
 		{
-			msg = QSharedPointer< Message > ( new DeinitSourceMessage );
-		} break;
+			m_version = Protocol::Version2;
+			m_bytesRead = Protocol::prefaceSize;
 
-		default :
-			return QSharedPointer < Message > ();
+			return PrefaceDecoded;
+		}
+
+		if( magicNumber != c_magicNumber )
+			return Garbage;
+
+		if( data.size() < c_headerSize )
+			return NeedMoreData;
+
+		m_messageType = qFromBigEndian< quint16 > ( data.data() + 8 );
+		m_messageLength = qFromBigEndian< quint16 > ( data.data() + 10 );
+		pos = c_headerSize;
 	}
 
-	if( !msg->deserialize( msgData ) )
-		throw GarbageReceivedException();
+	if( !isMessageType( m_messageType ) )
+		return Garbage;
+
+	m_headerSize = pos;
 
-	return msg;
+	return MessageDecoded;
 }
 
 } /* namespace Como */
@@ -34,6 +34,7 @@
 // Qt include.
 #include <QSharedPointer>
 #include <QString>
+#include <QByteArrayView>
 
 // C++ include.
 #include <stdexcept>
@@ -101,31 +102,180 @@ public:
 // Protocol
 //
 
-//! Protocol for exchanging messages between server and client.
+/*!
+	Protocol for exchanging messages between server and client.
+
+	Message of the protocol #1 has 12 bytes header: 8 bytes of
+	magic number, 2 bytes of type and 2 bytes of size, so its
+	data is limited by 64 KiB.
+
+	Message of the protocol #2 has type and size as varints,
+	usually 2-4 bytes. Magic number is sent only once in the
+	preface. Side sending the preface continues with protocol #2,
+	the other side replies with the preface and switches too.
+	Older sides never send the preface and keep protocol #1.
+*/
 class Protocol {
 public:
+	//! Version of the protocol.
+	enum Version {
+		//! Protocol #1.
+		Version1 = 1,
+		//! Protocol #2.
+		Version2 = 2
+	}; // enum Version
+
+	//! Size of the preface.
+	static const int prefaceSize = 8;
+
 	/*!
 		Write message.
 
+		Throws ProtocolException if message is too large
+		for the protocol #1.
+
 		\return Data to transfer over TCP/IP network.
 	*/
 	static QSharedPointer< QByteArray > writeMessage(
 		//! Message to be written to.
-		const Message & msg );
+		const Message & msg,
+		//! Version of the protocol.
+		Version version = Version2 );
 
 	/*!
 		Read message.
 
-		Can throw exceptions: ProtocolException
-		and GarbageReceivedException.
+		Can throw exceptions: NotEnoughDataReceivedException
+		and GarbageReceivedException. Use MessageDecoder when
+		incomplete messages are expected.
 	*/
 	static QSharedPointer< Message > readMessage(
-		//! Data to read message from.
-		const QByteArray & data,
+		//! Data to read message from, message doesn't reference it.
+		QByteArrayView data,
 		//! Actual count of bytes that were read from.
-		int & bytesRead );
+		int & bytesRead,
+		//! Version of the protocol.
+		Version version = Version2 );
+
+	//! \return Preface of the protocol #2.
+	static QByteArray preface();
+
+	/*!
+		\return Message of the protocol #2 written in the protocol #1.
+		Empty if message is too large for the protocol #1.
+	*/
+	static QByteArray toVersion1( const QByteArray & data );
+
+	/*!
+		\return CompressedMessage with the given messages written in
+		the given version of the protocol. Empty if compressed data
+		isn't smaller or is too large for the protocol #1.
+	*/
+	static QByteArray compressMessages( const QByteArray & messages,
+		Version version );
+
+	/*!
+		\return Messages uncompressed from the data of CompressedMessage.
+		Empty if data is broken or uncompressed size declared in
+		it is bigger than maximum size of the message, so garbage
+		doesn't make us allocate gigabytes.
+	*/
+	static QByteArray uncompressMessages( const QByteArray & compressed );
 }; // class Protocol
 
+
+//
+// MessageVisitor
+//
+
+//! Receiver of the messages decoded by MessageDecoder.
+class MessageVisitor {
+public:
+	virtual ~MessageVisitor();
+
+	/*!
+		Handle message. Message lives on the stack of the decoder
+		and is destroyed right after the call.
+	*/
+	virtual void visit( const Message & msg ) = 0;
+}; // class MessageVisitor
+
+
+//
+// MessageDecoder
+//
+
+/*!
+	Incremental decoder of the messages, doesn't throw exceptions.
+
+	Data passed to decode() must start with not consumed bytes,
+	i.e. bytesRead() of the previous decoded message must be removed
+	from the beginning, and not consumed data must be passed again with
+	new data appended. Parsed header of the incomplete message is kept
+	between calls, so it's not parsed again when more data arrive.
+
+	Decoded message is created on the stack by its type and passed
+	to the visitor, so decoding doesn't allocate the message on the heap.
+*/
+class MessageDecoder {
+public:
+	//! Status of the decoding.
+	enum Status {
+		//! Message is incomplete, nothing is consumed.
+		NeedMoreData,
+		//! Message decoded and visited, see bytesRead().
+		MessageDecoded,
+		/*!
+			Preface of the protocol #2 received, see bytesRead().
+			Decoder continues with the protocol #2.
+		*/
+		PrefaceDecoded,
+		//! Garbage received, decoder must be reset.
+		Garbage
+	}; // enum Status
+
+	explicit MessageDecoder(
+		Protocol::Version version = Protocol::Version2 );
+
+	//! \return Version of the protocol.
+	Protocol::Version version() const;
+
+	//! Reset decoder to the initial state with the given version.
+	void reset( Protocol::Version version );
+
+	/*!
+		Decode next message and pass it to the visitor.
+
+		Preface is recognized only in the protocol #1.
+		Visitor may reset the decoder and destroy the data,
+		they aren't used after the visit.
+	*/
+	Status decode( QByteArrayView data, MessageVisitor & visitor );
+
+	//! \return Count of bytes consumed by the last decode().
+	int bytesRead() const;
+
+private:
+	/*!
+		Parse header of the next message.
+
+		\return MessageDecoded if header is parsed.
+	*/
+	Status decodeHeader( QByteArrayView data );
+
+private:
+	//! Version of the protocol.
+	Protocol::Version m_version;
+	//! Size of the parsed header, 0 if header isn't parsed yet.
+	int m_headerSize;
+	//! Type of the message.
+	quint64 m_messageType;
+	//! Length of the message's data.
+	quint64 m_messageLength;
+	//! Count of bytes consumed by the last decode().
+	int m_bytesRead;
+}; // class MessageDecoder
+
 } /* namespace Como */
 
 #endif // COMO__PROTOCOL_HPP__INCLUDED
@@ -0,0 +1,264 @@
+
+/*!
+	\file
+
+	\author Igor Mironchik (igor.mironchik at gmail dot com).
+
+	Copyright (c) 2012 Igor Mironchik
+
+	Permission is hereby granted, free of charge, to any person
+	obtaining a copy of this software and associated documentation
+	files (the "Software"), to deal in the Software without
+	restriction, including without limitation the rights to use,
+	copy, modify, merge, publish, distribute, sublicense, and/or sell
+	copies of the Software, and to permit persons to whom the
+	Software is furnished to do so, subject to the following
+	conditions:
+
+	The above copyright notice and this permission notice shall be
+	included in all copies or substantial portions of the Software.
+
+	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+	EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+	OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+	NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+	HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+	WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+	FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+	OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+// Como include.
+#include <Como/private/ReceivedSources>
+#include <Como/private/Messages>
+
+// Qt include.
+#include <QList>
+
+
+namespace Como {
+
+//
+// ReceivedSources
+//
+
+ReceivedSources::ReceivedSources( const SourceCallback & updated,
+	const SourceCallback & deinitialized,
+	const UnknownSourceCallback & unknown )
+	:	m_updated( updated )
+	,	m_deinitialized( deinitialized )
+	,	m_unknown( unknown )
+	,	m_isResuming( false )
+{
+}
+
+void
+ReceivedSources::clear()
+{
+	m_sourcesById.clear();
+	m_ids.clear();
+	m_receivedValues.clear();
+	m_isResuming = false;
+	m_resumedSources.clear();
+}
+
+void
+ReceivedSources::beginResume()
+{
+	m_isResuming = true;
+	m_resumedSources.clear();
+}
+
+void
+ReceivedSources::endResume( bool isSnapshot )
+{
+	if( !m_isResuming )
+		return;
+
+	m_isResuming = false;
+
+	if( isSnapshot )
+	{
+		QList< Source > stale;
+
+		for( auto it = m_sourcesById.cbegin(), last = m_sourcesById.cend();
+			it != last; ++it )
+		{
+			if( !m_resumedSources.contains( sourceKey( it.value() ) ) )
+				stale.append( it.value() );
+		}
+
+		foreach( const Source & source, stale )
+		{
+			const quint32 id = m_ids.take( sourceKey( source ) );
+
+			m_sourcesById.remove( id );
+			m_receivedValues.remove( id );
+
+			m_deinitialized( source );
+		}
+	}
+
+	m_resumedSources.clear();
+}
+
+bool
+ReceivedSources::isSourcesMessage( quint16 type )
+{
+	switch( type )
+	{
+		case SourceMessage::messageType :
+		case DeinitSourceMessage::messageType :
+		case SourcesListMessage::messageType :
+		case InitSourceMessage::messageType :
+		case SourceValueMessage::messageType :
+		case SourceDeltaMessage::messageType :
+			return true;
+
+		default :
+			return false;
+	}
+}
+
+bool
+ReceivedSources::handleMessage( const Message & msg )
+{
+	switch( msg.type() )
+	{
+		case SourceMessage::messageType :
+		{
+			const SourceMessage & sourceMsg =
+				static_cast< const SourceMessage& > ( msg );
+
+			markReceived( sourceMsg.source() );
+
+			m_updated( sourceMsg.source() );
+		} break;
+
+		case DeinitSourceMessage::messageType :
+		{
+			const DeinitSourceMessage & deinitMsg =
+				static_cast< const DeinitSourceMessage& > ( msg );
+
+			const quint32 id = m_ids.take( sourceKey( deinitMsg.source() ) );
+
+			if( id )
+			{
+				m_sourcesById.remove( id );
+				m_receivedValues.remove( id );
+			}
+
+			m_deinitialized( deinitMsg.source() );
+		} break;
+
+		case SourcesListMessage::messageType :
+		{
+			const SourcesListMessage & listMsg =
+				static_cast< const SourcesListMessage& > ( msg );
+
+			for( int i = 0; i < listMsg.sources().size(); ++i )
+			{
+				const Source & source = listMsg.sources().at( i );
+
+				rememberSource( listMsg.ids().value( i, 0 ), source );
+				markReceived( source );
+
+				m_updated( source );
+			}
+		} break;
+
+		case InitSourceMessage::messageType :
+		{
+			const InitSourceMessage & initMsg =
+				static_cast< const InitSourceMessage& > ( msg );
+
+			rememberSource( initMsg.id(), initMsg.source() );
+			markReceived( initMsg.source() );
+
+			m_receivedValues.insert( initMsg.id(), initMsg.source().value() );
+
+			m_updated( initMsg.source() );
+		} break;
+
+		case SourceValueMessage::messageType :
+		{
+			const SourceValueMessage & valueMsg =
+				static_cast< const SourceValueMessage& > ( msg );
+
+			m_receivedValues.insert( valueMsg.id(), valueMsg.value() );
+
+			const auto it = m_sourcesById.find( valueMsg.id() );
+
+			// Source wasn't announced to us, for example it was
+			// initialized while we were subscribed to other sources.
+			if( it == m_sourcesById.end() )
+			{
+				m_unknown();
+
+				break;
+			}
+
+			it.value().setValue( valueMsg.value() );
+			it.value().setDateTime( valueMsg.dateTime() );
+
+			markReceived( it.value() );
+
+			m_updated( it.value() );
+		} break;
+
+		case SourceDeltaMessage::messageType :
+		{
+			const SourceDeltaMessage & deltaMsg =
+				static_cast< const SourceDeltaMessage& > ( msg );
+
+			const auto base = m_receivedValues.find( deltaMsg.id() );
+
+			// Delta against unknown value, we are out of sync.
+			if( base == m_receivedValues.end() )
+				return false;
+
+			base.value() = SourceDeltaMessage::decode( base.value(),
+				deltaMsg.delta() );
+
+			const auto it = m_sourcesById.find( deltaMsg.id() );
+
+			if( it == m_sourcesById.end() )
+			{
+				m_unknown();
+
+				break;
+			}
+
+			it.value().setValue( base.value() );
+			it.value().setDateTime( deltaMsg.dateTime() );
+
+			markReceived( it.value() );
+
+			m_updated( it.value() );
+		} break;
+
+		default :
+			break;
+	}
+
+	return true;
+}
+
+void
+ReceivedSources::rememberSource( quint32 id, const Source & source )
+{
+	if( !id )
+		return;
+
+	m_sourcesById.insert( id, source );
+	m_ids.insert( sourceKey( source ), id );
+}
+
+void
+ReceivedSources::markReceived( const Source & source )
+{
+	if( m_isResuming )
+		m_resumedSources.insert( sourceKey( source ) );
+}
+
+} /* namespace Como */
@@ -0,0 +1,137 @@
+
+/*!
+	\file
+
+	\author Igor Mironchik (igor.mironchik at gmail dot com).
+
+	Copyright (c) 2012 Igor Mironchik
+
+	Permission is hereby granted, free of charge, to any person
+	obtaining a copy of this software and associated documentation
+	files (the "Software"), to deal in the Software without
+	restriction, including without limitation the rights to use,
+	copy, modify, merge, publish, distribute, sublicense, and/or sell
+	copies of the Software, and to permit persons to whom the
+	Software is furnished to do so, subject to the following
+	conditions:
+
+	The above copyright notice and this permission notice shall be
+	included in all copies or substantial portions of the Software.
+
+	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+	EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+	OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+	NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+	HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+	WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+	FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+	OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#ifndef COMO__RECEIVED_SOURCES_HPP__INCLUDED
+#define COMO__RECEIVED_SOURCES_HPP__INCLUDED
+
+// Como include.
+#include <Como/Source>
+#include <Como/private/SourceKey>
+
+// Qt include.
+#include <QHash>
+#include <QSet>
+#include <QVariant>
+
+// C++ include.
+#include <functional>
+
+
+namespace Como {
+
+class Message;
+
+
+//
+// ReceivedSources
+//
+
+/*!
+	Sources received from the server.
+
+	Restores sources from the messages with ids of the
+	sources and deltas of the values, so all kinds of
+	client connections handle messages about sources
+	in the same way.
+*/
+class ReceivedSources {
+public:
+	//! Callback with the source.
+	typedef std::function< void ( const Source & ) > SourceCallback;
+	//! Callback invoked when message refers to the unknown source.
+	typedef std::function< void () > UnknownSourceCallback;
+
+	ReceivedSources(
+		//! Invoked when source has updated value.
+		const SourceCallback & updated,
+		//! Invoked when source was de-initialized.
+		const SourceCallback & deinitialized,
+		/*!
+			Invoked when message refers to the source we don't
+			know about. List of sources should be requested.
+		*/
+		const UnknownSourceCallback & unknown );
+
+	//! Forget all received sources, for example on reconnection.
+	void clear();
+
+	/*!
+		Start tracking of the received sources. Client resumes
+		the session and server may reply with list of all sources.
+	*/
+	void beginResume();
+	/*!
+		Finish tracking of the received sources. If server sent list
+		of all sources then sources not received since beginResume()
+		were de-initialized while we were disconnected.
+	*/
+	void endResume( bool isSnapshot );
+
+	//! \return Is message of this type about sources?
+	static bool isSourcesMessage( quint16 type );
+
+	/*!
+		Handle message about sources.
+
+		\return false if delta of the unknown value received,
+		i.e. we are out of sync with the server.
+	*/
+	bool handleMessage( const Message & msg );
+
+private:
+	//! Remember id of the received source.
+	void rememberSource( quint32 id, const Source & source );
+	//! Mark source as received while resuming.
+	void markReceived( const Source & source );
+
+private:
+	Q_DISABLE_COPY( ReceivedSources )
+
+	//! Invoked when source has updated value.
+	SourceCallback m_updated;
+	//! Invoked when source was de-initialized.
+	SourceCallback m_deinitialized;
+	//! Invoked when message refers to the unknown source.
+	UnknownSourceCallback m_unknown;
+	//! Received sources by their ids.
+	QHash< quint32, Source > m_sourcesById;
+	//! Ids of the received sources.
+	QHash< SourceKey, quint32 > m_ids;
+	//! Last values received by ids of the sources, bases of deltas.
+	QHash< quint32, QVariant > m_receivedValues;
+	//! Are received sources tracked?
+	bool m_isResuming;
+	//! Sources received since beginResume().
+	QSet< SourceKey > m_resumedSources;
+}; // class ReceivedSources
+
+} /* namespace Como */
+
+#endif // COMO__RECEIVED_SOURCES_HPP__INCLUDED
@@ -0,0 +1,508 @@
+
+/*!
+	\file
+
+	\author Igor Mironchik (igor.mironchik at gmail dot com).
+
+	Copyright (c) 2012 Igor Mironchik
+
+	Permission is hereby granted, free of charge, to any person
+	obtaining a copy of this software and associated documentation
+	files (the "Software"), to deal in the Software without
+	restriction, including without limitation the rights to use,
+	copy, modify, merge, publish, distribute, sublicense, and/or sell
+	copies of the Software, and to permit persons to whom the
+	Software is furnished to do so, subject to the following
+	conditions:
+
+	The above copyright notice and this permission notice shall be
+	included in all copies or substantial portions of the Software.
+
+	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+	EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+	OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+	NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+	HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+	WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+	FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+	OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+// Como include.
+#include <Como/private/SharedMemoryRing>
+
+// C++ include.
+#include <atomic>
+#include <cstring>
+#include <new>
+
+#ifdef Q_OS_LINUX
+	#include <sys/mman.h>
+	#include <sys/stat.h>
+	#include <sys/syscall.h>
+	#include <linux/futex.h>
+	#include <fcntl.h>
+	#include <unistd.h>
+	#include <signal.h>
+	#include <cerrno>
+	#include <climits>
+	#include <ctime>
+#endif
+
+
+namespace Como {
+
+//
+// SharedMemoryHeader
+//
+
+//! Header of the ring in the shared memory.
+struct SharedMemoryHeader {
+	//! Magic number.
+	quint64 m_magic;
+	//! Capacity of the ring in bytes.
+	quint32 m_capacity;
+	//! Process id of the writer.
+	qint64 m_writerPid;
+	//! Is ring closed by the writer?
+	std::atomic< quint32 > m_isClosed;
+	//! Writer can modify data up to this position.
+	std::atomic< quint64 > m_reservePos;
+	//! Position after the last written message.
+	std::atomic< quint64 > m_writePos;
+	//! Futex word, incremented on each write.
+	std::atomic< quint32 > m_futex;
+	//! Count of sleeping readers.
+	std::atomic< quint32 > m_waiters;
+	//! Count of snapshot requests.
+	std::atomic< quint32 > m_snapshotRequests;
+}; // struct SharedMemoryHeader
+
+static_assert( std::atomic< quint64 >::is_always_lock_free,
+	"Atomics in the shared memory must be lock-free." );
+
+//! Magic number of the ring, "COMORING".
+static const quint64 c_ringMagic = 0x434F4D4F52494E47;
+
+//! Length of the record that means "continue from the beginning".
+static const quint32 c_paddingMarker = 0xFFFFFFFF;
+
+//! \return Size of the record with message of the given size.
+static inline quint32
+recordSize( quint32 size )
+{
+	return ( ( sizeof( quint32 ) + size + 3 ) & ~quint32( 3 ) );
+}
+
+
+//
+// SharedMemoryRing
+//
+
+SharedMemoryRing::SharedMemoryRing()
+	:	m_header( 0 )
+	,	m_data( 0 )
+	,	m_mappedSize( 0 )
+	,	m_isWriter( false )
+{
+}
+
+SharedMemoryRing::~SharedMemoryRing()
+{
+	close();
+}
+
+#ifdef Q_OS_LINUX
+
+//
+// isAbandoned
+//
+
+/*!
+	\return Is existing shared memory with the given name a ring
+	left by the writer that has closed it or has died?
+*/
+static bool
+isAbandoned( const QByteArray & name )
+{
+	const int fd = shm_open( name.constData(), O_RDONLY, 0 );
+
+	if( fd == -1 )
+		return false;
+
+	struct stat st;
+
+	if( fstat( fd, &st ) == -1 ||
+		st.st_size < (off_t) sizeof( SharedMemoryHeader ) )
+	{
+		::close( fd );
+
+		return false;
+	}
+
+	void * memory = mmap( 0, sizeof( SharedMemoryHeader ), PROT_READ,
+		MAP_SHARED, fd, 0 );
+
+	::close( fd );
+
+	if( memory == MAP_FAILED )
+		return false;
+
+	const SharedMemoryHeader * header =
+		static_cast< const SharedMemoryHeader* > ( memory );
+
+	bool abandoned = false;
+
+	if( header->m_magic == c_ringMagic )
+	{
+		std::atomic_thread_fence( std::memory_order_acquire );
+
+		abandoned = ( header->m_isClosed.load( std::memory_order_relaxed ) ||
+			( kill( (pid_t) header->m_writerPid, 0 ) == -1 &&
+				errno == ESRCH ) );
+	}
+
+	munmap( memory, sizeof( SharedMemoryHeader ) );
+
+	return abandoned;
+}
+
+bool
+SharedMemoryRing::create( const QString & name, quint32 capacity )
+{
+	close();
+
+	capacity = qMax( ( capacity + 3 ) & ~quint32( 3 ), quint32( 4096 ) );
+
+	m_name = "/como." + name.toLocal8Bit();
+
+	int fd = shm_open( m_name.constData(), O_CREAT | O_EXCL | O_RDWR, 0600 );
+
+	// Ring of the live writer is never taken over.
+	if( fd == -1 && errno == EEXIST && isAbandoned( m_name ) )
+	{
+		shm_unlink( m_name.constData() );
+
+		fd = shm_open( m_name.constData(), O_CREAT | O_EXCL | O_RDWR, 0600 );
+	}
+
+	if( fd == -1 )
+		return false;
+
+	const size_t size = sizeof( SharedMemoryHeader ) + capacity;
+
+	if( ftruncate( fd, size ) == -1 )
+	{
+		::close( fd );
+		shm_unlink( m_name.constData() );
+
+		return false;
+	}
+
+	void * memory = mmap( 0, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0 );
+
+	::close( fd );
+
+	if( memory == MAP_FAILED )
+	{
+		shm_unlink( m_name.constData() );
+
+		return false;
+	}
+
+	m_header = new( memory ) SharedMemoryHeader;
+	m_header->m_capacity = capacity;
+	m_header->m_writerPid = getpid();
+	m_header->m_isClosed.store( 0 );
+	m_header->m_reservePos.store( 0 );
+	m_header->m_writePos.store( 0 );
+	m_header->m_futex.store( 0 );
+	m_header->m_waiters.store( 0 );
+	m_header->m_snapshotRequests.store( 0 );
+
+	std::atomic_thread_fence( std::memory_order_release );
+
+	m_header->m_magic = c_ringMagic;
+
+	m_data = static_cast< char* > ( memory ) + sizeof( SharedMemoryHeader );
+	m_mappedSize = size;
+	m_isWriter = true;
+
+	return true;
+}
+
+bool
+SharedMemoryRing::open( const QString & name )
+{
+	close();
+
+	m_name = "/como." + name.toLocal8Bit();
+
+	const int fd = shm_open( m_name.constData(), O_RDWR, 0 );
+
+	if( fd == -1 )
+		return false;
+
+	struct stat st;
+
+	if( fstat( fd, &st ) == -1 ||
+		st.st_size < (off_t) sizeof( SharedMemoryHeader ) )
+	{
+		::close( fd );
+
+		return false;
+	}
+
+	const size_t size = st.st_size;
+
+	void * memory = mmap( 0, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0 );
+
+	::close( fd );
+
+	if( memory == MAP_FAILED )
+		return false;
+
+	SharedMemoryHeader * header = static_cast< SharedMemoryHeader* > ( memory );
+
+	if( header->m_magic != c_ringMagic ||
+		sizeof( SharedMemoryHeader ) + header->m_capacity != size )
+	{
+		munmap( memory, size );
+
+		return false;
+	}
+
+	std::atomic_thread_fence( std::memory_order_acquire );
+
+	m_header = header;
+	m_data = static_cast< char* > ( memory ) + sizeof( SharedMemoryHeader );
+	m_mappedSize = size;
+	m_isWriter = false;
+
+	return true;
+}
+
+void
+SharedMemoryRing::close()
+{
+	if( !m_header )
+		return;
+
+	if( m_isWriter )
+	{
+		m_header->m_isClosed.store( 1, std::memory_order_release );
+		m_header->m_futex.fetch_add( 1, std::memory_order_seq_cst );
+
+		syscall( SYS_futex, &m_header->m_futex, FUTEX_WAKE, INT_MAX, 0, 0, 0 );
+
+		shm_unlink( m_name.constData() );
+	}
+
+	munmap( m_header, m_mappedSize );
+
+	m_header = 0;
+	m_data = 0;
+	m_mappedSize = 0;
+	m_isWriter = false;
+}
+
+bool
+SharedMemoryRing::write( const QByteArray & msg )
+{
+	if( !m_header || !m_isWriter )
+		return false;
+
+	const quint32 capacity = m_header->m_capacity;
+	const quint32 size = msg.size();
+	const quint32 record = recordSize( size );
+
+	if( record > capacity / 2 )
+		return false;
+
+	quint64 pos = m_header->m_writePos.load( std::memory_order_relaxed );
+	quint32 offset = pos % capacity;
+	quint32 padding = 0;
+
+	if( offset + record > capacity )
+	{
+		padding = capacity - offset;
+		pos += padding;
+	}
+
+	// Readers check this position after copying, so they
+	// know that data they have read can be overwritten.
+	m_header->m_reservePos.store( pos + record, std::memory_order_relaxed );
+
+	std::atomic_thread_fence( std::memory_order_release );
+
+	if( padding )
+	{
+		std::memcpy( m_data + offset, &c_paddingMarker, sizeof( quint32 ) );
+
+		offset = 0;
+	}
+
+	std::memcpy( m_data + offset, &size, sizeof( quint32 ) );
+	std::memcpy( m_data + offset + sizeof( quint32 ), msg.constData(), size );
+
+	m_header->m_writePos.store( pos + record, std::memory_order_release );
+	m_header->m_futex.fetch_add( 1, std::memory_order_seq_cst );
+
+	if( m_header->m_waiters.load( std::memory_order_seq_cst ) )
+		syscall( SYS_futex, &m_header->m_futex, FUTEX_WAKE, INT_MAX, 0, 0, 0 );
+
+	return true;
+}
+
+SharedMemoryRing::ReadStatus
+SharedMemoryRing::read( quint64 & pos, QByteArray & msg ) const
+{
+	if( !m_header )
+		return Closed;
+
+	const quint32 capacity = m_header->m_capacity;
+
+	while( true )
+	{
+		if( m_header->m_isClosed.load( std::memory_order_acquire ) )
+			return Closed;
+
+		const quint64 writePos =
+			m_header->m_writePos.load( std::memory_order_acquire );
+
+		if( pos == writePos )
+			return Empty;
+
+		if( writePos - pos > capacity )
+			return Overrun;
+
+		const quint32 offset = pos % capacity;
+
+		quint32 size = 0;
+		std::memcpy( &size, m_data + offset, sizeof( quint32 ) );
+
+		if( size == c_paddingMarker )
+		{
+			std::atomic_thread_fence( std::memory_order_acquire );
+
+			if( m_header->m_reservePos.load( std::memory_order_relaxed ) - pos >
+				capacity )
+					return Overrun;
+
+			pos += capacity - offset;
+
+			continue;
+		}
+
+		const quint32 record = recordSize( size );
+
+		// Size was overwritten by the writer.
+		if( record > capacity / 2 || offset + record > capacity )
+			return Overrun;
+
+		msg = QByteArray( m_data + offset + sizeof( quint32 ), size );
+
+		std::atomic_thread_fence( std::memory_order_acquire );
+
+		if( m_header->m_reservePos.load( std::memory_order_relaxed ) - pos >
+			capacity )
+				return Overrun;
+
+		pos += record;
+
+		return Read;
+	}
+}
+
+void
+SharedMemoryRing::wait( quint32 sequence, int msec )
+{
+	if( !m_header )
+		return;
+
+	m_header->m_waiters.fetch_add( 1, std::memory_order_seq_cst );
+
+	struct timespec timeout;
+	timeout.tv_sec = msec / 1000;
+	timeout.tv_nsec = ( msec % 1000 ) * 1000000;
+
+	// Returns immediately if sequence was already changed.
+	syscall( SYS_futex, &m_header->m_futex, FUTEX_WAIT, sequence,
+		&timeout, 0, 0 );
+
+	m_header->m_waiters.fetch_sub( 1, std::memory_order_seq_cst );
+}
+
+#else
+
+bool
+SharedMemoryRing::create( const QString &, quint32 )
+{
+	return false;
+}
+
+bool
+SharedMemoryRing::open( const QString & )
+{
+	return false;
+}
+
+void
+SharedMemoryRing::close()
+{
+}
+
+bool
+SharedMemoryRing::write( const QByteArray & )
+{
+	return false;
+}
+
+SharedMemoryRing::ReadStatus
+SharedMemoryRing::read( quint64 &, QByteArray & ) const
+{
+	return Closed;
+}
+
+void
+SharedMemoryRing::wait( quint32, int )
+{
+}
+
+#endif // Q_OS_LINUX
+
+bool
+SharedMemoryRing::isOpen() const
+{
+	return ( m_header != 0 );
+}
+
+quint32
+SharedMemoryRing::snapshotRequests() const
+{
+	return ( m_header ?
+		m_header->m_snapshotRequests.load( std::memory_order_relaxed ) : 0 );
+}
+
+quint64
+SharedMemoryRing::writePosition() const
+{
+	return ( m_header ?
+		m_header->m_writePos.load( std::memory_order_acquire ) : 0 );
+}
+
+quint32
+SharedMemoryRing::sequence() const
+{
+	return ( m_header ?
+		m_header->m_futex.load( std::memory_order_acquire ) : 0 );
+}
+
+void
+SharedMemoryRing::requestSnapshot()
+{
+	if( m_header )
+		m_header->m_snapshotRequests.fetch_add( 1, std::memory_order_relaxed );
+}
+
+} /* namespace Como */
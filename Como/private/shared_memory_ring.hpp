@@ -0,0 +1,141 @@
+
+/*!
+	\file
+
+	\author Igor Mironchik (igor.mironchik at gmail dot com).
+
+	Copyright (c) 2012 Igor Mironchik
+
+	Permission is hereby granted, free of charge, to any person
+	obtaining a copy of this software and associated documentation
+	files (the "Software"), to deal in the Software without
+	restriction, including without limitation the rights to use,
+	copy, modify, merge, publish, distribute, sublicense, and/or sell
+	copies of the Software, and to permit persons to whom the
+	Software is furnished to do so, subject to the following
+	conditions:
+
+	The above copyright notice and this permission notice shall be
+	included in all copies or substantial portions of the Software.
+
+	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+	EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+	OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+	NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+	HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+	WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+	FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+	OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#ifndef COMO__SHARED_MEMORY_RING_HPP__INCLUDED
+#define COMO__SHARED_MEMORY_RING_HPP__INCLUDED
+
+// Qt include.
+#include <QString>
+#include <QByteArray>
+
+
+namespace Como {
+
+struct SharedMemoryHeader;
+
+
+//
+// SharedMemoryRing
+//
+
+/*!
+	Ring buffer of the serialized messages in the
+	POSIX shared memory.
+
+	One writer (ServerSocket) appends messages, any count
+	of readers in other processes read them with their own
+	positions. Writer never waits for readers, reader that
+	was overtaken by the writer gets Overrun status and must
+	request snapshot. Readers sleep on the futex in the
+	shared memory while there is nothing to read.
+
+	Supported only on Linux, on other platforms create()
+	and open() fail.
+*/
+class SharedMemoryRing {
+public:
+	//! Status of the read.
+	enum ReadStatus {
+		//! Message was read.
+		Read,
+		//! Nothing to read.
+		Empty,
+		//! Writer overtook reader, messages were lost.
+		Overrun,
+		//! Writer closed the ring.
+		Closed
+	}; // enum ReadStatus
+
+	SharedMemoryRing();
+	~SharedMemoryRing();
+
+	/*!
+		Create shared memory with the given name and
+		capacity of the ring in bytes.
+
+		Fails if the ring with this name is used by another
+		writer. Ring left by the writer that has died is
+		taken over.
+	*/
+	bool create( const QString & name, quint32 capacity );
+	//! Open shared memory created by the writer.
+	bool open( const QString & name );
+	/*!
+		Close shared memory. If this is writer then
+		readers get Closed status and memory is unlinked.
+	*/
+	void close();
+	//! \return Is shared memory opened?
+	bool isOpen() const;
+
+	/*!
+		Append message and wake up sleeping readers.
+		Messages larger than half of the capacity are
+		not written.
+	*/
+	bool write( const QByteArray & msg );
+	//! \return Count of snapshot requests made by readers.
+	quint32 snapshotRequests() const;
+
+	//! \return Position after the last written message.
+	quint64 writePosition() const;
+	/*!
+		Read message at the given position. On success
+		position is moved to the next message.
+	*/
+	ReadStatus read( quint64 & pos, QByteArray & msg ) const;
+	//! Ask writer to write snapshot of all sources.
+	void requestSnapshot();
+	//! \return Sequence number of the writes, changes on each write.
+	quint32 sequence() const;
+	/*!
+		Sleep until sequence number of the writes will differ
+		from the given one or timeout in milliseconds will expire.
+	*/
+	void wait( quint32 sequence, int msec );
+
+private:
+	Q_DISABLE_COPY( SharedMemoryRing )
+
+	//! Name of the shared memory.
+	QByteArray m_name;
+	//! Header of the ring.
+	SharedMemoryHeader * m_header;
+	//! Data of the ring.
+	char * m_data;
+	//! Size of the mapping.
+	size_t m_mappedSize;
+	//! Is this writer?
+	bool m_isWriter;
+}; // class SharedMemoryRing
+
+} /* namespace Como */
+
+#endif // COMO__SHARED_MEMORY_RING_HPP__INCLUDED
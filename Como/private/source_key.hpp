@@ -0,0 +1,69 @@
+
+/*!
+	\file
+
+	\author Igor Mironchik (igor.mironchik at gmail dot com).
+
+	Copyright (c) 2012 Igor Mironchik
+
+	Permission is hereby granted, free of charge, to any person
+	obtaining a copy of this software and associated documentation
+	files (the "Software"), to deal in the Software without
+	restriction, including without limitation the rights to use,
+	copy, modify, merge, publish, distribute, sublicense, and/or sell
+	copies of the Software, and to permit persons to whom the
+	Software is furnished to do so, subject to the following
+	conditions:
+
+	The above copyright notice and this permission notice shall be
+	included in all copies or substantial portions of the Software.
+
+	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+	EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+	OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+	NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+	HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+	WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+	FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+	OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#ifndef COMO__SOURCE_KEY_HPP__INCLUDED
+#define COMO__SOURCE_KEY_HPP__INCLUDED
+
+// Como include.
+#include <Como/Source>
+
+// Qt include.
+#include <QPair>
+#include <QString>
+#include <QHash>
+
+
+namespace Como {
+
+//
+// SourceKey
+//
+
+/*!
+	Key of the source. Sources are identified
+	by the name and the type name.
+*/
+typedef QPair< QString, QString > SourceKey;
+
+
+//
+// sourceKey
+//
+
+//! \return Key of the given source.
+inline SourceKey
+sourceKey( const Source & source )
+{
+	return SourceKey( source.name(), source.typeName() );
+}
+
+} /* namespace Como */
+
+#endif // COMO__SOURCE_KEY_HPP__INCLUDED
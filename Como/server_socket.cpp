@@ -31,70 +31,151 @@
 // Como include.
 #include <Como/ServerSocket>
 #include <Como/ClientSocket>
+#include <Como/LocalClientSocket>
 #include <Como/Source>
+#include <Como/private/Protocol>
+#include <Como/private/Messages>
+#include <Como/private/SourceKey>
+#include <Como/private/MpscQueue>
+#include <Como/private/Frame>
+#include <Como/private/ClientsGroup>
+#include <Como/private/SharedMemoryRing>
+#include <Como/private/MulticastDatagram>
 
 // Qt include.
-#include <QMutexLocker>
 #include <QList>
-#include <QMutex>
+#include <QHash>
+#include <QMultiMap>
+#include <QSet>
+#include <QTimer>
+#include <QElapsedTimer>
 #include <QEvent>
+#include <QThread>
+#include <QMetaObject>
 #include <QCoreApplication>
+#include <QUdpSocket>
+#include <QLocalServer>
+#include <QLocalSocket>
+#include <QRandomGenerator>
+
+// C++ include.
+#include <atomic>
+#include <functional>
+#include <deque>
 
 
 namespace Como {
 
 //
-// SourceHasUpdatedValueEvent
+// SourceOperation
 //
 
-static const int SourceHasUpdatedValueEventType =
-	QEvent::registerEventType();
+//! Operation with the source, queued by the producer's thread.
+struct SourceOperation {
+	//! Type of the operation.
+	enum Type {
+		//! Source was initialized.
+		Init,
+		//! Value of the source was updated.
+		Update,
+		//! Source was deinitialized.
+		Deinit
+	}; // enum Type
 
-class SourceHasUpdatedValueEvent
-	:	public QEvent
-{
-public:
-	explicit SourceHasUpdatedValueEvent( const Source & source )
-		:	QEvent( static_cast< QEvent::Type > ( SourceHasUpdatedValueEventType ) )
-		,	m_source( source )
+	SourceOperation()
+		:	m_type( Update )
 	{
 	}
 
-	const Source & source() const
+	SourceOperation( Type type, const Source & source )
+		:	m_type( type )
+		,	m_source( source )
 	{
-		return m_source;
 	}
 
-private:
+	//! Type of the operation.
+	Type m_type;
+	//! Source.
 	Source m_source;
-}; // class SourceHasUpdatedValueEvent
+}; // struct SourceOperation
 
 
 //
-// SourceHasDeinitializedEvent
+// SourceOperationsQueuedEvent
 //
 
-static const int SourceHasDeinitializedEventType =
+static const int SourceOperationsQueuedEventType =
 	QEvent::registerEventType();
 
-class SourceHasDeinitializedEvent
+/*!
+	This event is posted to the ServerSocket when
+	new operations are queued. Only one such event
+	can be pending at any time.
+*/
+class SourceOperationsQueuedEvent
 	:	public QEvent
 {
 public:
-	explicit SourceHasDeinitializedEvent( const Source & source )
-		:	QEvent( static_cast< QEvent::Type > ( SourceHasDeinitializedEventType ) )
-		,	m_source( source )
+	SourceOperationsQueuedEvent()
+		:	QEvent( static_cast< QEvent::Type > ( SourceOperationsQueuedEventType ) )
+	{
+	}
+}; // class SourceOperationsQueuedEvent
+
+
+//
+// estimatedSerializedSize
+//
+
+//! \return Estimated size of the serialized source, never less than real.
+static int
+estimatedSerializedSize( const Source & source )
+{
+	int size = 64;
+
+	size += 2 * ( source.name().size() + source.typeName().size() +
+		source.description().size() );
+
+	if( source.type() == Source::String )
+		size += 2 * source.value().toString().size();
+
+	return size;
+}
+
+//
+// LocalServer
+//
+
+//! Local server passing accepted connections to the callback.
+class LocalServer
+	:	public QLocalServer
+{
+public:
+	LocalServer( const std::function< void ( quintptr ) > & callback,
+		QObject * parent )
+		:	QLocalServer( parent )
+		,	m_callback( callback )
 	{
 	}
 
-	const Source & source() const
+protected:
+	void incomingConnection( quintptr socketDescriptor ) override
 	{
-		return m_source;
+		m_callback( socketDescriptor );
 	}
 
 private:
-	Source m_source;
-}; // class SourceHasDeinitializedEvent
+	//! Callback of the accepted connection.
+	std::function< void ( quintptr ) > m_callback;
+}; // class LocalServer
+
+
+/*!
+	Maximum size of the data of SourcesListMessage.
+	Size of the message is 16 bits in the protocol #1,
+	so we keep it well below 64 KiB for older clients.
+*/
+static const int c_maxSourcesListSize = 32 * 1024;
 
 
 //
@@ -102,12 +183,512 @@ private:
 //
 
 struct ServerSocket::ServerSocketPrivate {
-	//! List of client sockets.
-	QList< ClientSocket* > m_clientSockets;
-	//! List of all available sources.
-	QList< Source > m_sources;
-	//! Mutex.
-	QMutex m_mutex;
+	ServerSocketPrivate()
+		:	m_publishInterval( 0 )
+		,	m_publishTimer( 0 )
+		,	m_isEventPosted( false )
+		,	m_isSourcesListValid( false )
+		,	m_nextGroup( 0 )
+		,	m_groupsGeneration( 0 )
+		,	m_lastSourceId( 0 )
+		,	m_throttleTimer( 0 )
+		,	m_sharedMemoryTimer( 0 )
+		,	m_snapshotRequests( 0 )
+		,	m_multicastSocket( 0 )
+		,	m_multicastPort( 0 )
+		,	m_multicastSequence( 0 )
+		,	m_localServer( 0 )
+		,	m_session( 0 )
+		,	m_sequence( 0 )
+		,	m_replayCapacity( 10000 )
+	{
+		m_clock.start();
+
+		// Zero session means that client has no session.
+		while( !m_session )
+			m_session = QRandomGenerator::global()->generate64();
+	}
+
+	/*!
+		\return Should value of the source be delayed because
+		of its maximum publish rate? Delayed source is sent
+		out by the throttle timer with the newest value.
+	*/
+	bool isThrottled( const SourceKey & key, const Source & source )
+	{
+		if( source.maxPublishRate() <= 0 )
+		{
+			m_lastPublished.remove( key );
+
+			return false;
+		}
+
+		if( m_delayedSources.contains( key ) )
+			return true;
+
+		const qint64 now = m_clock.elapsed();
+		const qint64 window = qMax( 1000 / source.maxPublishRate(), 1 );
+
+		const auto it = m_lastPublished.find( key );
+
+		if( it != m_lastPublished.end() && now - it.value() < window )
+		{
+			const qint64 deadline = it.value() + window;
+
+			// Timer is restarted only for the new nearest deadline.
+			const bool isNearest = ( m_deadlines.isEmpty() ||
+				deadline < m_deadlines.firstKey() );
+
+			m_delayedSources.insert( key, deadline );
+			m_deadlines.insert( deadline, key );
+
+			if( isNearest )
+				startThrottleTimer();
+
+			return true;
+		}
+
+		m_lastPublished.insert( key, now );
+
+		return false;
+	}
+
+	//! Start throttle timer for the nearest delayed source.
+	void startThrottleTimer()
+	{
+		if( m_deadlines.isEmpty() )
+		{
+			m_throttleTimer->stop();
+
+			return;
+		}
+
+		m_throttleTimer->start( (int) qMax(
+			m_deadlines.firstKey() - m_clock.elapsed(), qint64( 0 ) ) );
+	}
+
+	//! Forget about the throttling of the source.
+	void removeThrottling( const SourceKey & key )
+	{
+		m_lastPublished.remove( key );
+
+		const auto it = m_delayedSources.constFind( key );
+
+		if( it != m_delayedSources.constEnd() )
+		{
+			const qint64 deadline = it.value();
+			const bool isNearest = ( deadline == m_deadlines.firstKey() );
+
+			m_deadlines.remove( deadline, key );
+			m_delayedSources.erase( it );
+
+			if( isNearest )
+				startThrottleTimer();
+		}
+	}
+
+	//! \return Serialized SourcesListMessage with the given sources.
+	QByteArray serializeSourcesList( const QList< SourceKey > & keys ) const
+	{
+		QList< Source > chunk;
+		QList< quint32 > chunkIds;
+
+		foreach( const SourceKey & key, keys )
+		{
+			chunk.append( m_sources.value( key ) );
+			chunkIds.append( m_sourceIds.value( key ) );
+		}
+
+		return *Protocol::writeMessage( SourcesListMessage( chunk, chunkIds ) );
+	}
+
+	/*!
+		\return Estimated size of the serialized SourcesListMessage
+		with the given sources.
+	*/
+	int estimatedSourcesListSize( const QList< SourceKey > & keys ) const
+	{
+		int size = 0;
+
+		foreach( const SourceKey & key, keys )
+			size += estimatedSerializedSize( m_sources.value( key ) );
+
+		return size;
+	}
+
+	/*!
+		Mark part of the list of sources with the given
+		source as changed, only this part is serialized again.
+	*/
+	void invalidateSourcesList( const SourceKey & key )
+	{
+		if( !m_isSourcesListValid )
+			return;
+
+		const auto it = m_sourcesListChunkOf.constFind( key );
+
+		if( it != m_sourcesListChunkOf.constEnd() )
+			m_dirtySourcesListChunks.insert( it.value() );
+		else
+			m_isSourcesListValid = false;
+	}
+
+	/*!
+		\return Serialized SourcesListMessage messages with all
+		available sources. They are cached until sources are
+		initialized or deinitialized. When values change only
+		parts with changed sources are serialized again.
+	*/
+	const QList< QByteArray > & sourcesList()
+	{
+		if( m_isSourcesListValid )
+		{
+			foreach( int index, m_dirtySourcesListChunks )
+			{
+				const QList< SourceKey > & keys =
+					m_sourcesListChunks.at( index );
+
+				// Grown values don't fit into the part any more.
+				if( keys.size() > 1 &&
+					estimatedSourcesListSize( keys ) > c_maxSourcesListSize )
+				{
+					m_isSourcesListValid = false;
+
+					break;
+				}
+
+				m_sourcesList[ index ] = serializeSourcesList( keys );
+			}
+
+			m_dirtySourcesListChunks.clear();
+		}
+
+		if( !m_isSourcesListValid )
+		{
+			m_sourcesList.clear();
+			m_sourcesListChunks.clear();
+			m_sourcesListChunkOf.clear();
+			m_dirtySourcesListChunks.clear();
+
+			QList< SourceKey > chunk;
+			int chunkSize = 0;
+
+			for( auto it = m_sources.cbegin(), last = m_sources.cend();
+				it != last; ++it )
+			{
+				const int size = estimatedSerializedSize( it.value() );
+
+				if( !chunk.isEmpty() && chunkSize + size > c_maxSourcesListSize )
+				{
+					m_sourcesList.append( serializeSourcesList( chunk ) );
+					m_sourcesListChunks.append( chunk );
+
+					chunk.clear();
+					chunkSize = 0;
+				}
+
+				m_sourcesListChunkOf.insert( it.key(), m_sourcesListChunks.size() );
+				chunk.append( it.key() );
+				chunkSize += size;
+			}
+
+			// Empty list is sent too, so client knows that
+			// its request was handled.
+			if( !chunk.isEmpty() || m_sourcesList.isEmpty() )
+			{
+				m_sourcesList.append( serializeSourcesList( chunk ) );
+				m_sourcesListChunks.append( chunk );
+			}
+
+			m_isSourcesListValid = true;
+		}
+
+		return m_sourcesList;
+	}
+
+	/*!
+		\return SourceMessage with the source for clients without
+		enabled ids. It's serialized only when such client needs it,
+		usually all clients have ids enabled.
+	*/
+	static FramePayload legacyPayload( const Source & source )
+	{
+		return FramePayload( [ source ] () {
+			return *Protocol::writeMessage( SourceMessage( source ) ); } );
+	}
+
+	/*!
+		\return Frame with initialization of the source. Clients
+		with enabled ids receive all information about the source
+		with its id.
+	*/
+	Frame initFrame( const SourceKey & key, const Source & source ) const
+	{
+		const quint32 id = m_sourceIds.value( key );
+
+		Frame frame( Frame::SourceInit, legacyPayload( source ), key,
+			*Protocol::writeMessage( InitSourceMessage( id, source ) ) );
+
+		frame.m_id = id;
+		frame.m_dateTime = source.dateTime();
+		frame.m_value = source.value();
+
+		return frame;
+	}
+
+	/*!
+		\return Frame with value of the source. Clients with
+		enabled ids receive only id, date and time and value,
+		or delta of the value.
+	*/
+	Frame valueFrame( const SourceKey & key, const Source & source ) const
+	{
+		const quint32 id = m_sourceIds.value( key );
+
+		Frame frame( Frame::SourceValue, legacyPayload( source ), key,
+			*Protocol::writeMessage( SourceValueMessage( id, source ) ) );
+
+		frame.m_id = id;
+		frame.m_dateTime = source.dateTime();
+		frame.m_value = source.value();
+
+		return frame;
+	}
+
+	//! \return Frame with deinitialization of the source.
+	Frame deinitFrame( const SourceKey & key, const Source & source ) const
+	{
+		const QByteArray data =
+			*Protocol::writeMessage( DeinitSourceMessage( source ) );
+
+		// The same message for all clients.
+		Frame frame( Frame::SourceDeinit, data, key, data );
+
+		frame.m_id = m_sourceIds.value( key );
+
+		return frame;
+	}
+
+	//! \return Frame with the sequence number of the last published frame.
+	Frame sequenceFrame( SequenceMessage::Kind kind ) const
+	{
+		return Frame( Frame::Sequence, *Protocol::writeMessage(
+			SequenceMessage( m_session, m_sequence, kind ) ) );
+	}
+
+	//! \return Frames with all available sources.
+	QList< Frame > snapshotFrames( ClientSocket::Capabilities capabilities )
+	{
+		QList< Frame > frames;
+
+		if( capabilities.testFlag( ClientSocket::BatchedSourcesListCapability ) )
+		{
+			foreach( const QByteArray & data, sourcesList() )
+				frames.append( Frame( Frame::Other, data ) );
+		}
+		else
+		{
+			for( auto it = m_sources.cbegin(), last = m_sources.cend();
+				it != last; ++it )
+				frames.append( initFrame( it.key(), it.value() ) );
+		}
+
+		frames.append( sequenceFrame( SequenceMessage::Snapshot ) );
+
+		return frames;
+	}
+
+	/*!
+		Fill frames published after the given sequence number.
+		Value is skipped if a later frame of the same source
+		follows it, so client receives only the latest values.
+
+		\return false if these frames aren't in the replay ring.
+	*/
+	bool replayFrames( quint64 session, quint64 sequence,
+		QList< Frame > & frames ) const
+	{
+		if( session != m_session || sequence > m_sequence ||
+			m_sequence - sequence > m_replayRing.size() )
+				return false;
+
+		const quint64 count = m_sequence - sequence;
+
+		QSet< SourceKey > later;
+		std::deque< Frame >::const_reverse_iterator it = m_replayRing.crbegin();
+
+		for( quint64 i = 0; i < count; ++i, ++it )
+		{
+			if( it->m_kind == Frame::SourceValue && later.contains( it->m_key ) )
+				continue;
+
+			later.insert( it->m_key );
+			frames.prepend( *it );
+		}
+
+		frames.append( sequenceFrame( SequenceMessage::Resumed ) );
+
+		return true;
+	}
+
+	//! Put published frames to the replay ring.
+	void record( const QList< Frame > & frames )
+	{
+		foreach( const Frame & frame, frames )
+		{
+			++m_sequence;
+
+			if( m_replayCapacity > 0 )
+				m_replayRing.push_back( frame );
+		}
+
+		while( m_replayRing.size() > (size_t) m_replayCapacity )
+			m_replayRing.pop_front();
+	}
+
+	/*!
+		Send frames to all clients. Frames are shared
+		between all groups, each group sends them
+		to its clients in its own thread.
+	*/
+	void publish( const QList< Frame > & frames )
+	{
+		if( frames.isEmpty() )
+			return;
+
+		record( frames );
+
+		if( m_ring.isOpen() )
+		{
+			foreach( const Frame & frame, frames )
+				m_ring.write( frame.m_compactData.isEmpty() ?
+					frame.m_data.data() : frame.m_compactData.data() );
+		}
+
+		if( m_multicastSocket )
+			sendMulticast( frames );
+
+		QList< Frame > sequenced = frames;
+		sequenced.append( sequenceFrame( SequenceMessage::Updates ) );
+
+		foreach( ClientsGroup * group, m_groups )
+			QMetaObject::invokeMethod( group,
+				[ group, sequenced ] () { group->sendFrames( sequenced ); } );
+	}
+
+	/*!
+		Send frames to the multicast group. Frames are packed
+		into datagrams, each datagram has its own sequence number.
+	*/
+	void sendMulticast( const QList< Frame > & frames )
+	{
+		QByteArray datagram;
+
+		foreach( const Frame & frame, frames )
+		{
+			const QByteArray & data = ( frame.m_compactData.isEmpty() ?
+				frame.m_data.data() : frame.m_compactData.data() );
+
+			if( !datagram.isEmpty() &&
+				datagram.size() + data.size() > MulticastDatagram::c_maxSize )
+			{
+				m_multicastSocket->writeDatagram( datagram,
+					m_multicastAddress, m_multicastPort );
+
+				datagram.clear();
+			}
+
+			if( datagram.isEmpty() )
+				datagram = MulticastDatagram::header( ++m_multicastSequence );
+
+			datagram.append( data );
+		}
+
+		if( !datagram.isEmpty() )
+			m_multicastSocket->writeDatagram( datagram,
+				m_multicastAddress, m_multicastPort );
+	}
+
+	//! Apply settings of the clients to all groups.
+	void applySettings()
+	{
+		const ClientSocketSettings settings = m_settings;
+
+		foreach( ClientsGroup * group, m_groups )
+			QMetaObject::invokeMethod( group,
+				[ group, settings ] () { group->setSettings( settings ); } );
+	}
+
+	//! All available sources.
+	QHash< SourceKey, Source > m_sources;
+	//! Sources updated since the last publish.
+	QSet< SourceKey > m_updatedSources;
+	//! Publish interval.
+	int m_publishInterval;
+	//! Publish timer.
+	QTimer * m_publishTimer;
+	//! Operations queued by the producers.
+	MpscQueue< SourceOperation > m_operations;
+	//! Is SourceOperationsQueuedEvent posted?
+	std::atomic< bool > m_isEventPosted;
+	//! Settings of the clients.
+	ClientSocketSettings m_settings;
+	//! Cached serialized list of all sources.
+	QList< QByteArray > m_sourcesList;
+	//! Is cached list of sources valid?
+	bool m_isSourcesListValid;
+	//! Sources of each part of the cached list of sources.
+	QList< QList< SourceKey > > m_sourcesListChunks;
+	//! Index of the part of the cached list of sources with the source.
+	QHash< SourceKey, int > m_sourcesListChunkOf;
+	//! Parts of the cached list of sources with changed sources.
+	QSet< int > m_dirtySourcesListChunks;
+	//! Groups of the clients.
+	QList< ClientsGroup* > m_groups;
+	//! I/O threads.
+	QList< QThread* > m_threads;
+	//! Index of the group for the next client.
+	int m_nextGroup;
+	//! Incremented when groups are destroyed.
+	int m_groupsGeneration;
+	//! Ids of the available sources.
+	QHash< SourceKey, quint32 > m_sourceIds;
+	//! Last assigned id of the source.
+	quint32 m_lastSourceId;
+	//! Time of the last publish of the sources with limited rate.
+	QHash< SourceKey, qint64 > m_lastPublished;
+	//! Sources delayed by the rate limit with time when they must be sent.
+	QHash< SourceKey, qint64 > m_delayedSources;
+	//! Delayed sources ordered by time when they must be sent.
+	QMultiMap< qint64, SourceKey > m_deadlines;
+	//! Throttle timer.
+	QTimer * m_throttleTimer;
+	//! Clock of the throttling.
+	QElapsedTimer m_clock;
+	//! Ring in the shared memory.
+	SharedMemoryRing m_ring;
+	//! Timer of the checking of snapshot requests in the shared memory.
+	QTimer * m_sharedMemoryTimer;
+	//! Count of handled snapshot requests in the shared memory.
+	quint32 m_snapshotRequests;
+	//! Multicast socket.
+	QUdpSocket * m_multicastSocket;
+	//! Address of the multicast group.
+	QHostAddress m_multicastAddress;
+	//! Port of the multicast group.
+	quint16 m_multicastPort;
+	//! Sequence number of the last multicast datagram.
+	quint64 m_multicastSequence;
+	//! Server of the local clients.
+	LocalServer * m_localServer;
+	//! Session of the server, distinguishes restarted servers.
+	quint64 m_session;
+	//! Sequence number of the last published frame.
+	quint64 m_sequence;
+	//! Recently published frames, the last one has m_sequence.
+	std::deque< Frame > m_replayRing;
+	//! Maximum count of frames in the replay ring.
+	int m_replayCapacity;
 }; // struct ServerSocket::ServerSocketPrivate
 
 
@@ -119,96 +700,389 @@ ServerSocket::ServerSocket( QObject * parent )
 	:	QTcpServer( parent )
 	,	d( new ServerSocketPrivate )
 {
+	d->m_publishTimer = new QTimer( this );
+
+	connect( d->m_publishTimer, &QTimer::timeout,
+		this, &ServerSocket::slotPublishUpdatedSources );
+
+	d->m_throttleTimer = new QTimer( this );
+	d->m_throttleTimer->setSingleShot( true );
+
+	connect( d->m_throttleTimer, &QTimer::timeout,
+		this, &ServerSocket::slotPublishThrottledSources );
+
+	d->m_sharedMemoryTimer = new QTimer( this );
+
+	connect( d->m_sharedMemoryTimer, &QTimer::timeout,
+		this, &ServerSocket::slotCheckSharedMemorySnapshotRequests );
+
+	createClientsGroups( 0 );
 }
 
 ServerSocket::~ServerSocket()
 {
+	destroyClientsGroups();
 }
 
 void
 ServerSocket::initSource( const Source & source )
 {
-	QMutexLocker lock( &d->m_mutex );
+	queueOperation( SourceOperation( SourceOperation::Init, source ) );
+}
 
-	d->m_sources.append( source );
+void
+ServerSocket::updateSource( const Source & source )
+{
+	queueOperation( SourceOperation( SourceOperation::Update, source ) );
+}
 
-	QCoreApplication::postEvent( this,
-		new SourceHasUpdatedValueEvent( source ) );
+void
+ServerSocket::deinitSource( const Source & source )
+{
+	queueOperation( SourceOperation( SourceOperation::Deinit, source ) );
+}
+
+int
+ServerSocket::publishInterval() const
+{
+	return d->m_publishInterval;
 }
 
 void
-ServerSocket::updateSource( const Source & source )
+ServerSocket::setPublishInterval( int msec )
 {
-	QMutexLocker lock( &d->m_mutex );
+	d->m_publishInterval = qMax( msec, 0 );
 
-	const int index = d->m_sources.indexOf( source );
+	if( d->m_publishInterval > 0 )
+		d->m_publishTimer->start( d->m_publishInterval );
+	else
+	{
+		d->m_publishTimer->stop();
 
-	if( index )
-		d->m_sources[ index ] = source;
+		slotPublishUpdatedSources();
+	}
+}
 
-	QCoreApplication::postEvent( this,
-		new SourceHasUpdatedValueEvent( source ) );
+ClientSocket::SlowClientPolicy
+ServerSocket::slowClientPolicy() const
+{
+	return d->m_settings.m_policy;
 }
 
 void
-ServerSocket::deinitSource( const Source & source )
+ServerSocket::setSlowClientPolicy( ClientSocket::SlowClientPolicy policy )
 {
-	QMutexLocker lock( &d->m_mutex );
+	d->m_settings.m_policy = policy;
+
+	d->applySettings();
+}
+
+qint64
+ServerSocket::maxBytesToWrite() const
+{
+	return d->m_settings.m_maxBytesToWrite;
+}
 
-	const int index = d->m_sources.indexOf( source );
+void
+ServerSocket::setMaxBytesToWrite( qint64 bytes )
+{
+	d->m_settings.m_maxBytesToWrite = qMax( bytes, qint64( 0 ) );
 
-	if( index )
-		d->m_sources.removeAt( index );
+	d->applySettings();
+}
 
-	QCoreApplication::postEvent( this,
-		new SourceHasDeinitializedEvent( source ) );
+int
+ServerSocket::maxPendingMessages() const
+{
+	return d->m_settings.m_maxPendingMessages;
 }
 
 void
-ServerSocket::incomingConnection( qintptr socketDescriptor )
+ServerSocket::setMaxPendingMessages( int count )
 {
-	ClientSocket * socket = new ClientSocket( this );
+	d->m_settings.m_maxPendingMessages = qMax( count, 0 );
 
-	if( socket->setSocketDescriptor( socketDescriptor ) )
-	{
-		connect( socket, &ClientSocket::disconnected,
-			this, &ServerSocket::slotClientDisconnected,
-			Qt::QueuedConnection );
+	d->applySettings();
+}
 
-		connect( socket, &ClientSocket::getListOfSourcesMessageReceived,
-			this, &ServerSocket::slotGetListOfSourcesMessageReceived,
-			Qt::QueuedConnection );
+quint64
+ServerSocket::conflatedMessagesCount() const
+{
+	quint64 count = 0;
 
-		{
-			QMutexLocker lock( &d->m_mutex );
+	foreach( ClientsGroup * group, d->m_groups )
+		count += group->conflatedMessagesCount();
 
-			d->m_clientSockets.append( socket );
-		}
+	return count;
+}
 
-		emit clientConnected( socket );
-	}
-	else
+quint64
+ServerSocket::droppedMessagesCount() const
+{
+	quint64 count = 0;
+
+	foreach( ClientsGroup * group, d->m_groups )
+		count += group->droppedMessagesCount();
+
+	return count;
+}
+
+quint64
+ServerSocket::slowClientsDisconnectedCount() const
+{
+	quint64 count = 0;
+
+	foreach( ClientsGroup * group, d->m_groups )
+		count += group->slowClientsDisconnectedCount();
+
+	return count;
+}
+
+int
+ServerSocket::maxWriteDelay() const
+{
+	return d->m_settings.m_maxWriteDelay;
+}
+
+void
+ServerSocket::setMaxWriteDelay( int msec )
+{
+	d->m_settings.m_maxWriteDelay = qMax( msec, 0 );
+
+	d->applySettings();
+}
+
+bool
+ServerSocket::isLowDelay() const
+{
+	return d->m_settings.m_isLowDelay;
+}
+
+void
+ServerSocket::setLowDelay( bool on )
+{
+	d->m_settings.m_isLowDelay = on;
+
+	d->applySettings();
+}
+
+int
+ServerSocket::compressionThreshold() const
+{
+	return d->m_settings.m_compressionThreshold;
+}
+
+void
+ServerSocket::setCompressionThreshold( int bytes )
+{
+	d->m_settings.m_compressionThreshold = qMax( bytes, 0 );
+
+	d->applySettings();
+}
+
+int
+ServerSocket::replayCapacity() const
+{
+	return d->m_replayCapacity;
+}
+
+void
+ServerSocket::setReplayCapacity( int count )
+{
+	d->m_replayCapacity = qMax( count, 0 );
+
+	while( d->m_replayRing.size() > (size_t) d->m_replayCapacity )
+		d->m_replayRing.pop_front();
+}
+
+int
+ServerSocket::ioThreadsCount() const
+{
+	return d->m_threads.size();
+}
+
+void
+ServerSocket::setIoThreadsCount( int count )
+{
+	count = qMax( count, 0 );
+
+	if( count == d->m_threads.size() )
+		return;
+
+	destroyClientsGroups();
+	createClientsGroups( count );
+}
+
+//! Interval of the checking of snapshot requests in the shared memory.
+static const int c_snapshotRequestsCheckInterval = 50;
+
+/*!
+	Minimum capacity of the shared memory. Messages larger than
+	half of the capacity aren't written to the ring, so each
+	chunk of the list of sources must fit into it with room
+	to spare.
+*/
+static const quint32 c_minSharedMemoryCapacity = 4 * c_maxSourcesListSize;
+
+bool
+ServerSocket::listenSharedMemory( const QString & name, quint32 capacity )
+{
+	closeSharedMemory();
+
+	if( capacity < c_minSharedMemoryCapacity )
+		return false;
+
+	if( !d->m_ring.create( name, capacity ) )
+		return false;
+
+	d->m_snapshotRequests = 0;
+	d->m_sharedMemoryTimer->start( c_snapshotRequestsCheckInterval );
+
+	return true;
+}
+
+void
+ServerSocket::closeSharedMemory()
+{
+	d->m_sharedMemoryTimer->stop();
+	d->m_ring.close();
+}
+
+bool
+ServerSocket::isSharedMemoryListening() const
+{
+	return d->m_ring.isOpen();
+}
+
+bool
+ServerSocket::startMulticast( const QHostAddress & groupAddress, quint16 port )
+{
+	stopMulticast();
+
+	if( !groupAddress.isMulticast() )
+		return false;
+
+	QUdpSocket * socket = new QUdpSocket( this );
+
+	if( !socket->bind( groupAddress.protocol() == QAbstractSocket::IPv6Protocol ?
+		QHostAddress::AnyIPv6 : QHostAddress::AnyIPv4 ) )
+	{
 		delete socket;
+
+		return false;
+	}
+
+	socket->setSocketOption( QAbstractSocket::MulticastLoopbackOption, 1 );
+
+	d->m_multicastSocket = socket;
+	d->m_multicastAddress = groupAddress;
+	d->m_multicastPort = port;
+
+	return true;
 }
 
 void
-ServerSocket::customEvent( QEvent * e )
+ServerSocket::stopMulticast()
+{
+	delete d->m_multicastSocket;
+	d->m_multicastSocket = 0;
+}
+
+bool
+ServerSocket::isMulticasting() const
 {
-	if( e->type() == SourceHasUpdatedValueEventType )
+	return ( d->m_multicastSocket != 0 );
+}
+
+/*!
+	Timeout of the connecting to the local socket in use, ms.
+	The running server accepts the connection immediately.
+*/
+static const int c_localProbeTimeout = 1000;
+
+bool
+ServerSocket::listenLocal( const QString & name )
+{
+	closeLocal();
+
+	LocalServer * server = new LocalServer(
+		[ this ] ( quintptr socketDescriptor )
+			{ incomingLocalConnection( socketDescriptor ); },
+		this );
+
+	bool listening = server->listen( name );
+
+	// Remove the socket left by the crashed server, but only if
+	// nobody accepts connections on it: the running server must
+	// not lose its clients.
+	if( !listening &&
+		server->serverError() == QAbstractSocket::AddressInUseError )
 	{
-		SourceHasUpdatedValueEvent * updateEvent =
-			static_cast< SourceHasUpdatedValueEvent* > ( e );
+		QLocalSocket probe;
+		probe.connectToServer( name );
 
-		notifyAllClientsAboutValueChange( updateEvent->source() );
+		if( !probe.waitForConnected( c_localProbeTimeout ) )
+		{
+			QLocalServer::removeServer( name );
 
-		e->accept();
+			listening = server->listen( name );
+		}
 	}
-	else if( e->type() == SourceHasDeinitializedEventType )
+
+	if( !listening )
 	{
-		SourceHasDeinitializedEvent * deinitEvent =
-			static_cast< SourceHasDeinitializedEvent* > ( e );
+		delete server;
+
+		return false;
+	}
+
+	d->m_localServer = server;
+
+	return true;
+}
+
+void
+ServerSocket::closeLocal()
+{
+	delete d->m_localServer;
+	d->m_localServer = 0;
+}
+
+bool
+ServerSocket::isLocalListening() const
+{
+	return ( d->m_localServer != 0 );
+}
+
+void
+ServerSocket::incomingConnection( qintptr socketDescriptor )
+{
+	ClientsGroup * group = d->m_groups.at( d->m_nextGroup );
 
-		notifyAllClientsAboutDeinitSource( deinitEvent->source() );
+	d->m_nextGroup = ( d->m_nextGroup + 1 ) % d->m_groups.size();
+
+	QMetaObject::invokeMethod( group,
+		[ group, socketDescriptor ] () { group->addClient( socketDescriptor ); } );
+}
+
+void
+ServerSocket::incomingLocalConnection( quintptr socketDescriptor )
+{
+	ClientsGroup * group = d->m_groups.at( d->m_nextGroup );
+
+	d->m_nextGroup = ( d->m_nextGroup + 1 ) % d->m_groups.size();
+
+	QMetaObject::invokeMethod( group,
+		[ group, socketDescriptor ] ()
+			{ group->addLocalClient( socketDescriptor ); } );
+}
+
+void
+ServerSocket::customEvent( QEvent * e )
+{
+	if( e->type() == SourceOperationsQueuedEventType )
+	{
+		processQueuedOperations();
 
 		e->accept();
 	}
@@ -217,48 +1091,298 @@ ServerSocket::customEvent( QEvent * e )
 }
 
 void
-ServerSocket::slotClientDisconnected()
+ServerSocket::slotGetListOfSourcesRequested( Connection * connection,
+	ClientSocket::Capabilities capabilities )
 {
-	ClientSocket * socket = qobject_cast< ClientSocket* > ( sender() );
+	ClientsGroup * group = qobject_cast< ClientsGroup* > ( sender() );
 
-	{
-		QMutexLocker lock( &d->m_mutex );
+	if( !group )
+		return;
 
-		d->m_clientSockets.removeOne( socket );
-	}
+	const QList< Frame > frames = d->snapshotFrames( capabilities );
+
+	const bool isSourceIdsEnabled =
+		capabilities.testFlag( ClientSocket::SourceIdsCapability );
 
+	QMetaObject::invokeMethod( group,
+		[ group, connection, frames, isSourceIdsEnabled ] ()
+			{ group->sendFrames( connection, frames, isSourceIdsEnabled ); } );
+}
+
+void
+ServerSocket::slotResumeRequested( Connection * connection,
+	ClientSocket::Capabilities capabilities, quint64 session, quint64 sequence )
+{
+	ClientsGroup * group = qobject_cast< ClientsGroup* > ( sender() );
+
+	if( !group )
+		return;
+
+	QList< Frame > frames;
+
+	// Client has fallen off the ring, it receives all sources.
+	if( !d->replayFrames( session, sequence, frames ) )
+		frames = d->snapshotFrames( capabilities );
+
+	const bool isSourceIdsEnabled =
+		capabilities.testFlag( ClientSocket::SourceIdsCapability );
+
+	QMetaObject::invokeMethod( group,
+		[ group, connection, frames, isSourceIdsEnabled ] ()
+			{ group->sendFrames( connection, frames, isSourceIdsEnabled ); } );
+}
+
+void
+ServerSocket::slotClientDisconnected( ClientSocket * socket )
+{
 	emit clientDisconnected( socket );
 
+	// Socket lives in the thread of its group, it's
+	// deleted there after the signal was delivered here.
 	socket->deleteLater();
 }
 
 void
-ServerSocket::slotGetListOfSourcesMessageReceived()
+ServerSocket::slotLocalClientDisconnected( LocalClientSocket * socket )
+{
+	emit localClientDisconnected( socket );
+
+	socket->deleteLater();
+}
+
+void
+ServerSocket::slotPublishUpdatedSources()
+{
+	if( d->m_updatedSources.isEmpty() )
+		return;
+
+	QList< Frame > frames;
+	frames.reserve( d->m_updatedSources.size() );
+
+	foreach( const SourceKey & key, d->m_updatedSources )
+	{
+		const auto it = d->m_sources.constFind( key );
+
+		if( it != d->m_sources.constEnd() &&
+			!d->isThrottled( key, it.value() ) )
+				frames.append( d->valueFrame( key, it.value() ) );
+	}
+
+	d->m_updatedSources.clear();
+
+	d->publish( frames );
+}
+
+void
+ServerSocket::slotPublishThrottledSources()
+{
+	const qint64 now = d->m_clock.elapsed();
+
+	QList< Frame > frames;
+
+	while( !d->m_deadlines.isEmpty() && d->m_deadlines.firstKey() <= now )
+	{
+		const SourceKey key = d->m_deadlines.first();
+
+		d->m_deadlines.erase( d->m_deadlines.begin() );
+		d->m_delayedSources.remove( key );
+
+		const auto source = d->m_sources.constFind( key );
+
+		if( source != d->m_sources.constEnd() )
+		{
+			d->m_lastPublished.insert( key, now );
+			d->m_updatedSources.remove( key );
+
+			frames.append( d->valueFrame( key, source.value() ) );
+		}
+	}
+
+	d->startThrottleTimer();
+
+	d->publish( frames );
+}
+
+void
+ServerSocket::slotCheckSharedMemorySnapshotRequests()
 {
-	ClientSocket * socket = qobject_cast< ClientSocket* > ( sender() );
+	const quint32 requests = d->m_ring.snapshotRequests();
+
+	if( requests == d->m_snapshotRequests )
+		return;
 
-	QMutexLocker lock( &d->m_mutex );
+	d->m_snapshotRequests = requests;
 
-	foreach( const Source & source, d->m_sources )
-		socket->sendSourceMessage( source );
+	// Messages in the ring are shared by all clients,
+	// so snapshot always contains ids of the sources.
+	foreach( const QByteArray & data, d->sourcesList() )
+		d->m_ring.write( data );
 }
 
 void
-ServerSocket::notifyAllClientsAboutValueChange( const Source & source )
+ServerSocket::queueOperation( const SourceOperation & operation )
 {
-	QMutexLocker lock( &d->m_mutex );
+	d->m_operations.push( operation );
 
-	foreach( ClientSocket * socket, d->m_clientSockets )
-		socket->sendSourceMessage( source );
+	if( !d->m_isEventPosted.exchange( true ) )
+		QCoreApplication::postEvent( this, new SourceOperationsQueuedEvent );
 }
 
 void
-ServerSocket::notifyAllClientsAboutDeinitSource( const Source & source )
+ServerSocket::processQueuedOperations()
 {
-	QMutexLocker lock( &d->m_mutex );
+	d->m_isEventPosted.store( false );
+
+	QList< Frame > frames;
+
+	SourceOperation operation;
+
+	while( d->m_operations.pop( operation ) )
+	{
+		// Sources are read by the thread of the ServerSocket and
+		// by I/O threads, so raw data is converted only once.
+		Source & source = operation.m_source;
+		source.convertRawData();
+
+		const SourceKey key = sourceKey( source );
+
+		switch( operation.m_type )
+		{
+			case SourceOperation::Init :
+			{
+				d->m_isSourcesListValid = false;
+				d->m_sources.insert( key, source );
+
+				if( !d->m_sourceIds.contains( key ) )
+					d->m_sourceIds.insert( key, ++d->m_lastSourceId );
+
+				frames.append( d->initFrame( key, source ) );
+			} break;
+
+			case SourceOperation::Update :
+			{
+				const auto it = d->m_sources.find( key );
+
+				if( it == d->m_sources.end() )
+					break;
+
+				it.value() = source;
+
+				d->invalidateSourcesList( key );
+
+				if( d->m_publishInterval > 0 )
+					d->m_updatedSources.insert( key );
+				else if( !d->isThrottled( key, source ) )
+					frames.append( d->valueFrame( key, source ) );
+			} break;
+
+			case SourceOperation::Deinit :
+			{
+				d->m_isSourcesListValid = false;
+
+				frames.append( d->deinitFrame( key, source ) );
+
+				d->m_sources.remove( key );
+				d->m_sourceIds.remove( key );
+				d->m_updatedSources.remove( key );
+				d->removeThrottling( key );
+			} break;
+		}
+	}
+
+	d->publish( frames );
+}
+
+void
+ServerSocket::createClientsGroups( int threadsCount )
+{
+	if( threadsCount == 0 )
+		d->m_groups.append( new ClientsGroup( this ) );
+	else
+	{
+		for( int i = 0; i < threadsCount; ++i )
+		{
+			QThread * thread = new QThread;
+			ClientsGroup * group = new ClientsGroup;
+
+			group->moveToThread( thread );
+
+			connect( thread, &QThread::finished,
+				group, &QObject::deleteLater );
+
+			d->m_threads.append( thread );
+			d->m_groups.append( group );
+
+			thread->start();
+		}
+	}
+
+	const int generation = d->m_groupsGeneration;
+
+	foreach( ClientsGroup * group, d->m_groups )
+	{
+		// Signals queued before the groups were destroyed
+		// refer to sockets destroyed with their groups.
+		connect( group, &ClientsGroup::clientConnected, this,
+			[ this, generation ] ( ClientSocket * socket )
+			{
+				if( generation == d->m_groupsGeneration )
+					emit clientConnected( socket );
+			} );
+
+		connect( group, &ClientsGroup::clientDisconnected, this,
+			[ this, generation ] ( ClientSocket * socket )
+			{
+				if( generation == d->m_groupsGeneration )
+					slotClientDisconnected( socket );
+			} );
+
+		connect( group, &ClientsGroup::localClientConnected, this,
+			[ this, generation ] ( LocalClientSocket * socket )
+			{
+				if( generation == d->m_groupsGeneration )
+					emit localClientConnected( socket );
+			} );
+
+		connect( group, &ClientsGroup::localClientDisconnected, this,
+			[ this, generation ] ( LocalClientSocket * socket )
+			{
+				if( generation == d->m_groupsGeneration )
+					slotLocalClientDisconnected( socket );
+			} );
+
+		connect( group, &ClientsGroup::getListOfSourcesRequested,
+			this, &ServerSocket::slotGetListOfSourcesRequested );
+
+		connect( group, &ClientsGroup::resumeRequested,
+			this, &ServerSocket::slotResumeRequested );
+	}
+
+	d->m_nextGroup = 0;
+
+	d->applySettings();
+}
+
+void
+ServerSocket::destroyClientsGroups()
+{
+	if( d->m_threads.isEmpty() )
+		qDeleteAll( d->m_groups );
+	else
+	{
+		foreach( QThread * thread, d->m_threads )
+		{
+			thread->quit();
+			thread->wait();
+		}
+
+		qDeleteAll( d->m_threads );
+	}
+
+	d->m_threads.clear();
+	d->m_groups.clear();
 
-	foreach( ClientSocket * socket, d->m_clientSockets )
-		socket->sendDeinitSourceMessage( source );
+	++d->m_groupsGeneration;
 }
 
 } /* namespace Como */
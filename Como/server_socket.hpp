@@ -31,6 +31,10 @@
 #ifndef COMO__SERVER_SOCKET_HPP__INCLUDED
 #define COMO__SERVER_SOCKET_HPP__INCLUDED
 
+// Como include.
+#include <Como/ClientSocket>
+#include <Como/LocalClientSocket>
+
 // Qt include.
 #include <QTcpServer>
 #include <QScopedPointer>
@@ -39,7 +43,8 @@
 namespace Como {
 
 class Source;
-class ClientSocket;
+struct SourceOperation;
+class Connection;
 
 
 //
@@ -52,7 +57,13 @@ class ClientSocket;
 	to the constructor of the class Source, which is when
 	the state changed initiates a message to be sent out.
 
-	This class is thread-safe.
+	initSource(), updateSource(), deinitSource() and counters
+	of the messages and clients are thread-safe. Sources pass
+	their changes to the thread of the ServerSocket through the
+	lock-free queue, so producers never block each other or the
+	server. All other methods, including getters and setters of
+	the settings, must be invoked in the thread of the ServerSocket.
+	Settings are passed to the I/O threads as copies.
 */
 class ServerSocket
 	:	public QTcpServer
@@ -60,10 +71,34 @@ class ServerSocket
 	Q_OBJECT
 
 signals:
-	//! New client has connected;
+	/*!
+		New client has connected.
+
+		If I/O threads are used then client socket
+		lives in one of them.
+	*/
 	void clientConnected( Como::ClientSocket* );
-	//! Client has disconnected.
+	/*!
+		Client has disconnected.
+
+		Client socket is deleted later, after all
+		receivers of this signal are invoked.
+	*/
 	void clientDisconnected( Como::ClientSocket* );
+	/*!
+		New local client has connected.
+
+		If I/O threads are used then client socket
+		lives in one of them.
+	*/
+	void localClientConnected( Como::LocalClientSocket* );
+	/*!
+		Local client has disconnected.
+
+		Client socket is deleted later, after all
+		receivers of this signal are invoked.
+	*/
+	void localClientDisconnected( Como::LocalClientSocket* );
 
 public:
 	ServerSocket( QObject * parent = 0 );
@@ -91,6 +126,173 @@ public:
 	*/
 	void deinitSource( const Source & source );
 
+	//! \return Publish interval in milliseconds.
+	int publishInterval() const;
+	/*!
+		Set publish interval in milliseconds.
+
+		If interval is greater than zero then updates of the
+		sources are conflated: within each interval only the
+		latest value of each updated source is sent to the clients.
+		Zero (by default) means that each update is sent immediately.
+
+		Independently of this interval each source can limit
+		its own rate with Source::setMaxPublishRate().
+
+		This method should be invoked in the thread of the ServerSocket.
+	*/
+	void setPublishInterval( int msec );
+
+	//! \return Policy applied to the slow clients.
+	ClientSocket::SlowClientPolicy slowClientPolicy() const;
+	/*!
+		Set policy applied to the slow clients.
+
+		\sa ClientSocket::setSlowClientPolicy.
+	*/
+	void setSlowClientPolicy( ClientSocket::SlowClientPolicy policy );
+
+	//! \return Maximum count of bytes waiting to be written to each client.
+	qint64 maxBytesToWrite() const;
+	/*!
+		Set maximum count of bytes waiting to be written to each client.
+
+		\sa ClientSocket::setMaxBytesToWrite.
+	*/
+	void setMaxBytesToWrite( qint64 bytes );
+
+	//! \return Maximum count of pending messages of each client.
+	int maxPendingMessages() const;
+	/*!
+		Set maximum count of pending messages of each client.
+
+		\sa ClientSocket::setMaxPendingMessages.
+	*/
+	void setMaxPendingMessages( int count );
+
+	//! \return Maximum delay of the message before writing to each client.
+	int maxWriteDelay() const;
+	/*!
+		Set maximum delay in milliseconds of the message
+		before writing to each client.
+
+		\sa ClientSocket::setMaxWriteDelay.
+	*/
+	void setMaxWriteDelay( int msec );
+
+	//! \return Is TCP_NODELAY set for each client?
+	bool isLowDelay() const;
+	/*!
+		Set TCP_NODELAY for each client. This is useful for latency
+		sensitive deployments, usually together with zero
+		maxWriteDelay().
+	*/
+	void setLowDelay( bool on );
+
+	//! \return Minimum size of the collected messages to be compressed.
+	int compressionThreshold() const;
+	/*!
+		Set minimum size in bytes of the collected messages to be
+		compressed for each client supporting compression. Zero
+		disables compression. Default value is 1024.
+
+		\sa ClientSocket::setCompressionThreshold.
+	*/
+	void setCompressionThreshold( int bytes );
+
+	//! \return Count of conflated values for all clients.
+	quint64 conflatedMessagesCount() const;
+	//! \return Count of dropped values for all clients.
+	quint64 droppedMessagesCount() const;
+	//! \return Count of clients disconnected because they were too slow.
+	quint64 slowClientsDisconnectedCount() const;
+
+	//! \return Maximum count of updates kept to resume sessions.
+	int replayCapacity() const;
+	/*!
+		Set maximum count of the latest updates kept in memory.
+		Reconnected client resumes its session receiving only
+		missed updates if they are still kept, otherwise it
+		receives all sources. Zero disables resuming.
+		Default value is 10000.
+
+		This method should be invoked in the thread of the ServerSocket.
+	*/
+	void setReplayCapacity( int count );
+
+	//! \return Count of I/O threads.
+	int ioThreadsCount() const;
+	/*!
+		Set count of I/O threads.
+
+		Accepted clients are distributed between I/O threads,
+		each of them has its own event loop. Serialized messages
+		are shared between all threads. Zero (by default) means
+		that clients are served in the thread of the ServerSocket.
+
+		All connected clients are disconnected, so this method
+		should be invoked before listen().
+	*/
+	void setIoThreadsCount( int count );
+
+	/*!
+		Listen for the clients on the same host through the
+		shared memory with the given name and capacity in bytes.
+
+		Each message is written to the shared memory only once
+		for all SharedMemoryClient clients. Supported only on Linux.
+
+		Capacity must be at least 128 KiB, so each part of the list
+		of sources fits into the ring. Shared memory with the same
+		name used by another running server isn't taken over.
+
+		\return false if shared memory can't be created.
+	*/
+	bool listenSharedMemory( const QString & name,
+		quint32 capacity = 4 * 1024 * 1024 );
+	//! Close shared memory, all its clients will be disconnected.
+	void closeSharedMemory();
+	//! \return Is shared memory listening?
+	bool isSharedMemoryListening() const;
+
+	/*!
+		Listen for the LocalClientSocket clients on the same host
+		through the Unix domain socket (named pipe on Windows)
+		with the given name.
+
+		Local clients are served together with TCP clients: they
+		share list of sources, I/O threads and all settings, and
+		receive the same serialized messages.
+
+		Socket left by the crashed server is removed, socket of the
+		running server is not.
+
+		\return false if local server can't listen.
+	*/
+	bool listenLocal( const QString & name );
+	//! Stop listening for local clients, connected ones stay connected.
+	void closeLocal();
+	//! \return Is local server listening?
+	bool isLocalListening() const;
+
+	/*!
+		Start sending updates of the sources as UDP datagrams
+		to the given multicast group and port.
+
+		Each update is sent only once for all MulticastClient
+		clients, so cost of the server doesn't depend on count
+		of them. Lost datagrams are detected by sequence numbers,
+		clients request list of sources over TCP in this case,
+		so listen() should be invoked too.
+
+		\return false if multicast socket can't be created.
+	*/
+	bool startMulticast( const QHostAddress & groupAddress, quint16 port );
+	//! Stop sending updates to the multicast group.
+	void stopMulticast();
+	//! \return Are updates sent to the multicast group?
+	bool isMulticasting() const;
+
 protected:
 	//!	Process new incoming connection.
 	void incomingConnection( qintptr socketDescriptor );
@@ -98,16 +300,35 @@ protected:
 	void customEvent( QEvent * e );
 
 private slots:
-	//! Client was disconnected.
-	void slotClientDisconnected();
-	//! Received GetListOfSourcesMessage message.
-	void slotGetListOfSourcesMessageReceived();
+	//! Client requested list of all sources.
+	void slotGetListOfSourcesRequested( Como::Connection * connection,
+		Como::ClientSocket::Capabilities capabilities );
+	//! Client requested updates missed since the given sequence.
+	void slotResumeRequested( Como::Connection * connection,
+		Como::ClientSocket::Capabilities capabilities,
+		quint64 session, quint64 sequence );
+	//! Client of one of the groups has disconnected.
+	void slotClientDisconnected( Como::ClientSocket * socket );
+	//! Local client of one of the groups has disconnected.
+	void slotLocalClientDisconnected( Como::LocalClientSocket * socket );
+	//! Send out latest values of the updated sources.
+	void slotPublishUpdatedSources();
+	//! Send out values of the sources delayed by their maximum publish rate.
+	void slotPublishThrottledSources();
+	//! Write list of sources to the shared memory if it's requested.
+	void slotCheckSharedMemorySnapshotRequests();
 
 private:
-	//! Notify all clients about changes in value of the source.
-	void notifyAllClientsAboutValueChange( const Source & source );
-	//! Notify all clients about deinitialization of the source.
-	void notifyAllClientsAboutDeinitSource( const Source & source );
+	//! Process new incoming local connection.
+	void incomingLocalConnection( quintptr socketDescriptor );
+	//! Queue operation and wake up the thread of the ServerSocket.
+	void queueOperation( const SourceOperation & operation );
+	//! Process all queued operations.
+	void processQueuedOperations();
+	//! Create groups of the clients.
+	void createClientsGroups( int threadsCount );
+	//! Stop I/O threads and destroy groups of the clients.
+	void destroyClientsGroups();
 
 private:
 	struct ServerSocketPrivate;
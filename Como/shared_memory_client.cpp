@@ -0,0 +1,294 @@
+
+/*!
+	\file
+
+	\author Igor Mironchik (igor.mironchik at gmail dot com).
+
+	Copyright (c) 2012 Igor Mironchik
+
+	Permission is hereby granted, free of charge, to any person
+	obtaining a copy of this software and associated documentation
+	files (the "Software"), to deal in the Software without
+	restriction, including without limitation the rights to use,
+	copy, modify, merge, publish, distribute, sublicense, and/or sell
+	copies of the Software, and to permit persons to whom the
+	Software is furnished to do so, subject to the following
+	conditions:
+
+	The above copyright notice and this permission notice shall be
+	included in all copies or substantial portions of the Software.
+
+	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+	EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+	OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+	NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+	HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+	WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+	FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+	OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+// Como include.
+#include <Como/SharedMemoryClient>
+#include <Como/Source>
+#include <Como/private/SharedMemoryRing>
+#include <Como/private/ReceivedSources>
+#include <Como/private/Protocol>
+#include <Como/private/Messages>
+
+// Qt include.
+#include <QThread>
+#include <QEvent>
+#include <QCoreApplication>
+
+// C++ include.
+#include <atomic>
+
+
+namespace Como {
+
+//
+// MessagesAvailableEvent
+//
+
+static const int MessagesAvailableEventType = QEvent::registerEventType();
+
+/*!
+	This event is posted to the SharedMemoryClient when
+	server writes new messages. Only one such event can
+	be pending at any time.
+*/
+class MessagesAvailableEvent
+	:	public QEvent
+{
+public:
+	MessagesAvailableEvent()
+		:	QEvent( static_cast< QEvent::Type > ( MessagesAvailableEventType ) )
+	{
+	}
+}; // class MessagesAvailableEvent
+
+
+//
+// SharedMemoryClient::SharedMemoryClientPrivate
+//
+
+struct SharedMemoryClient::SharedMemoryClientPrivate
+	:	public MessageVisitor
+{
+	explicit SharedMemoryClientPrivate( SharedMemoryClient * q )
+		:	m_receivedSources(
+				[ q ] ( const Source & source )
+					{ emit q->sourceHasUpdatedValue( source ); },
+				[ q ] ( const Source & source )
+					{ emit q->sourceDeinitialized( source ); },
+				[ this ] ()
+					{
+						if( !m_isSnapshotRequested )
+						{
+							m_isSnapshotRequested = true;
+
+							m_ring.requestSnapshot();
+						}
+					} )
+		,	m_pos( 0 )
+		,	m_isSnapshotRequested( false )
+		,	m_thread( 0 )
+		,	m_isStopped( false )
+		,	m_isEventPosted( false )
+		,	m_isOutOfSync( false )
+	{
+	}
+
+	//! Handle message from the ring.
+	virtual void visit( const Message & msg )
+	{
+		if( !ReceivedSources::isSourcesMessage( msg.type() ) )
+			return;
+
+		if( msg.type() == SourcesListMessage::messageType )
+			m_isSnapshotRequested = false;
+
+		if( !m_receivedSources.handleMessage( msg ) )
+			m_isOutOfSync = true;
+	}
+
+	//! Ring in the shared memory.
+	SharedMemoryRing m_ring;
+	//! Sources received from the server.
+	ReceivedSources m_receivedSources;
+	//! Position of the next message in the ring.
+	quint64 m_pos;
+	//! Is snapshot requested and not received yet?
+	bool m_isSnapshotRequested;
+	//! Thread waiting for new messages.
+	QThread * m_thread;
+	//! Should waiting thread stop?
+	std::atomic< bool > m_isStopped;
+	//! Is MessagesAvailableEvent posted?
+	std::atomic< bool > m_isEventPosted;
+	//! Decoder of the messages from the ring.
+	MessageDecoder m_decoder;
+	//! Was delta of the unknown value received?
+	bool m_isOutOfSync;
+}; // struct SharedMemoryClient::SharedMemoryClientPrivate
+
+
+//
+// SharedMemoryClient
+//
+
+//! Timeout of the waiting for new messages to check for stop.
+static const int c_waitTimeout = 100;
+
+SharedMemoryClient::SharedMemoryClient( QObject * parent )
+	:	QObject( parent )
+	,	d( new SharedMemoryClientPrivate( this ) )
+{
+}
+
+SharedMemoryClient::~SharedMemoryClient()
+{
+	disconnectFrom();
+}
+
+bool
+SharedMemoryClient::isConnected() const
+{
+	return d->m_ring.isOpen();
+}
+
+bool
+SharedMemoryClient::connectTo( const QString & name )
+{
+	disconnectFrom();
+
+	if( !d->m_ring.open( name ) )
+		return false;
+
+	d->m_pos = d->m_ring.writePosition();
+	d->m_receivedSources.clear();
+	d->m_isStopped.store( false );
+	d->m_isEventPosted.store( false );
+
+	// Waiting thread only wakes up this object,
+	// messages are read in the thread of the object.
+	d->m_thread = QThread::create( [ this ] ()
+		{
+			quint32 sequence = d->m_ring.sequence();
+
+			while( !d->m_isStopped.load() )
+			{
+				d->m_ring.wait( sequence, c_waitTimeout );
+
+				const quint32 current = d->m_ring.sequence();
+
+				if( current != sequence )
+				{
+					sequence = current;
+
+					if( !d->m_isEventPosted.exchange( true ) )
+						QCoreApplication::postEvent( this,
+							new MessagesAvailableEvent );
+				}
+			}
+		} );
+
+	d->m_thread->start();
+
+	emit connected();
+
+	sendGetListOfSourcesMessage();
+
+	return true;
+}
+
+void
+SharedMemoryClient::disconnectFrom()
+{
+	if( !d->m_ring.isOpen() )
+		return;
+
+	d->m_isStopped.store( true );
+
+	d->m_thread->wait();
+
+	delete d->m_thread;
+	d->m_thread = 0;
+
+	d->m_ring.close();
+
+	emit disconnected();
+}
+
+void
+SharedMemoryClient::sendGetListOfSourcesMessage()
+{
+	if( !d->m_ring.isOpen() )
+		return;
+
+	d->m_isSnapshotRequested = true;
+
+	d->m_ring.requestSnapshot();
+}
+
+void
+SharedMemoryClient::customEvent( QEvent * e )
+{
+	if( e->type() == MessagesAvailableEventType )
+	{
+		readMessages();
+
+		e->accept();
+	}
+	else
+		e->ignore();
+}
+
+void
+SharedMemoryClient::readMessages()
+{
+	d->m_isEventPosted.store( false );
+
+	QByteArray data;
+
+	while( d->m_ring.isOpen() )
+	{
+		switch( d->m_ring.read( d->m_pos, data ) )
+		{
+			case SharedMemoryRing::Read :
+			{
+				d->m_isOutOfSync = false;
+
+				// Messages in the ring are always complete,
+				// so on error we are out of sync with the server.
+				if( d->m_decoder.decode( data, *d ) !=
+						MessageDecoder::MessageDecoded ||
+					d->m_isOutOfSync )
+				{
+					d->m_decoder.reset( Protocol::Version2 );
+					d->m_receivedSources.clear();
+
+					sendGetListOfSourcesMessage();
+				}
+			} break;
+
+			case SharedMemoryRing::Empty :
+				return;
+
+			case SharedMemoryRing::Overrun :
+			{
+				d->m_pos = d->m_ring.writePosition();
+
+				sendGetListOfSourcesMessage();
+			} break;
+
+			case SharedMemoryRing::Closed :
+			{
+				disconnectFrom();
+			} return;
+		}
+	}
+}
+
+} /* namespace Como */
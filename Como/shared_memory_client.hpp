@@ -0,0 +1,120 @@
+
+/*!
+	\file
+
+	\author Igor Mironchik (igor.mironchik at gmail dot com).
+
+	Copyright (c) 2012 Igor Mironchik
+
+	Permission is hereby granted, free of charge, to any person
+	obtaining a copy of this software and associated documentation
+	files (the "Software"), to deal in the Software without
+	restriction, including without limitation the rights to use,
+	copy, modify, merge, publish, distribute, sublicense, and/or sell
+	copies of the Software, and to permit persons to whom the
+	Software is furnished to do so, subject to the following
+	conditions:
+
+	The above copyright notice and this permission notice shall be
+	included in all copies or substantial portions of the Software.
+
+	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+	EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+	OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+	NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+	HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+	WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+	FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+	OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#ifndef COMO__SHARED_MEMORY_CLIENT_HPP__INCLUDED
+#define COMO__SHARED_MEMORY_CLIENT_HPP__INCLUDED
+
+// Qt include.
+#include <QObject>
+#include <QScopedPointer>
+#include <QString>
+
+
+namespace Como {
+
+class Source;
+
+
+//
+// SharedMemoryClient
+//
+
+/*!
+	Client of the ServerSocket on the same host.
+
+	Reads messages from the shared memory opened with
+	ServerSocket::listenSharedMemory(). There are no sockets,
+	messages are written by the server only once for all
+	clients and are read by the client directly from the
+	shared memory. Supported only on Linux.
+
+	Provides the same signals about sources as ClientSocket.
+
+	Don't forget register Source meta-type information in Qt with:
+
+	\code
+	qRegisterMetaType< Como::Source > ( "Como::Source" );
+	\endcode
+*/
+class SharedMemoryClient
+	:	public QObject
+{
+	Q_OBJECT
+
+signals:
+	//! Source has updated his value.
+	void sourceHasUpdatedValue( const Como::Source & );
+	//! De-initialization of the source.
+	void sourceDeinitialized( const Como::Source & );
+	//! Connected to the server.
+	void connected();
+	//! Disconnected from the server.
+	void disconnected();
+
+public:
+	explicit SharedMemoryClient( QObject * parent = 0 );
+	~SharedMemoryClient();
+
+	//! \return Is client connected?
+	bool isConnected() const;
+
+public slots:
+	/*!
+		Connect to the server listening shared memory with the
+		given name. List of sources is requested automatically.
+
+		\return false if there is no such shared memory.
+	*/
+	bool connectTo( const QString & name );
+
+	//! Disconnect from the server.
+	void disconnectFrom();
+
+	//! Request list of all sources.
+	void sendGetListOfSourcesMessage();
+
+protected:
+	//! Custom event.
+	void customEvent( QEvent * e );
+
+private:
+	//! Read all available messages.
+	void readMessages();
+
+private:
+	Q_DISABLE_COPY( SharedMemoryClient )
+
+	struct SharedMemoryClientPrivate;
+	QScopedPointer< SharedMemoryClientPrivate > d;
+}; // class SharedMemoryClient
+
+} /* namespace Como */
+
+#endif // COMO__SHARED_MEMORY_CLIENT_HPP__INCLUDED
@@ -32,9 +32,155 @@
 #include <Como/Source>
 #include <Como/ServerSocket>
 
+// Qt include.
+#include <QTime>
+
+// C++ include.
+#include <chrono>
+#include <ctime>
+#include <limits>
+#include <utility>
+
 
 namespace Como {
 
+namespace /* anonymous */ {
+
+//
+// realtimeClock
+//
+
+//! \return Nanoseconds since epoch, from coarse clock if isCoarse.
+qint64
+realtimeClock( bool isCoarse )
+{
+#ifdef CLOCK_REALTIME_COARSE
+	if( isCoarse )
+	{
+		timespec ts;
+
+		if( clock_gettime( CLOCK_REALTIME_COARSE, &ts ) == 0 )
+			return (qint64) ts.tv_sec * 1000000000 + ts.tv_nsec;
+	}
+#else
+	Q_UNUSED( isCoarse )
+#endif
+
+	return std::chrono::duration_cast< std::chrono::nanoseconds > (
+		std::chrono::system_clock::now().time_since_epoch() ).count();
+} // realtimeClock
+
+
+//
+// metaTypeId
+//
+
+//! \return Meta type id of the value of the source of the given type.
+int
+metaTypeId( Source::Type type )
+{
+	switch( type )
+	{
+		case Source::String : return QMetaType::QString;
+		case Source::Int : return QMetaType::Int;
+		case Source::UInt : return QMetaType::UInt;
+		case Source::LongLong : return QMetaType::LongLong;
+		case Source::ULongLong : return QMetaType::ULongLong;
+		case Source::Double : return QMetaType::Double;
+		case Source::DateTime : return QMetaType::QDateTime;
+		case Source::Time : return QMetaType::QTime;
+
+		default :
+			return QMetaType::UnknownType;
+	}
+} // metaTypeId
+
+
+//
+// convertedValue
+//
+
+//! \return Value converted to the type of the source.
+QVariant
+convertedValue( Source::Type type, QVariant value )
+{
+	const int typeId = metaTypeId( type );
+
+	if( typeId != QMetaType::UnknownType && value.typeId() != typeId )
+		value.convert( QMetaType( typeId ) );
+
+	return value;
+} // convertedValue
+
+
+//
+// integerValue
+//
+
+//! \return Integer value as QVariant of the type of the source.
+QVariant
+integerValue( Source::Type type, qint64 value, bool isUnsigned )
+{
+	switch( type )
+	{
+		case Source::Int : return QVariant( (int) value );
+		case Source::UInt : return QVariant( (uint) value );
+		case Source::LongLong : return QVariant( (qlonglong) value );
+		case Source::ULongLong : return QVariant( (qulonglong) value );
+		case Source::Double :
+			return ( isUnsigned ? QVariant( (double) (quint64) value ) :
+				QVariant( (double) value ) );
+
+		default :
+			return convertedValue( type, ( isUnsigned ?
+				QVariant( (qulonglong) value ) :
+				QVariant( (qlonglong) value ) ) );
+	}
+} // integerValue
+
+
+//
+// isIntegerFit
+//
+
+/*!
+	\return Can integer value be kept by the source of the given
+	type without loss? Numbers can't be dates or times.
+*/
+bool
+isIntegerFit( Source::Type type, qint64 value, bool isUnsigned )
+{
+	const quint64 u = (quint64) value;
+
+	switch( type )
+	{
+		case Source::Int :
+			return ( isUnsigned ?
+				u <= (quint64) std::numeric_limits< int >::max() :
+				( value >= std::numeric_limits< int >::min() &&
+					value <= std::numeric_limits< int >::max() ) );
+
+		case Source::UInt :
+			return ( ( isUnsigned || value >= 0 ) &&
+				u <= std::numeric_limits< uint >::max() );
+
+		case Source::LongLong :
+			return ( !isUnsigned || value >= 0 );
+
+		case Source::ULongLong :
+			return ( isUnsigned || value >= 0 );
+
+		case Source::DateTime :
+		case Source::Time :
+			return false;
+
+		default :
+			return true;
+	}
+} // isIntegerFit
+
+} /* namespace anonymous */
+
 
 //
 // Source
@@ -43,24 +189,38 @@ namespace Como {
 Source::Source()
 	:	m_type( Int )
 	,	m_serverSocket( Q_NULLPTR )
-	,	m_dateTime( QDateTime::currentDateTime() )
+	,	m_timestampMode( RealtimeClock )
+	,	m_timestamp( 0 )
 	,	m_value( QVariant( (int) 0 ) )
+	,	m_rawValue( NoRawValue )
+	,	m_rawInteger( 0 )
+	,	m_rawDouble( 0.0 )
+	,	m_maxPublishRate( 0 )
 {
+	updateTimestamp();
 }
 
 Source::Source( Type type, const QString & name,
 	const QString & typeName,
 	const QVariant & value,
 	const QString & desc,
-	ServerSocket * serverSocket )
+	ServerSocket * serverSocket,
+	int maxPublishRate )
 	:	m_type( type )
 	,	m_name( name )
 	,	m_typeName( typeName )
 	,	m_serverSocket( serverSocket )
-	,	m_dateTime( QDateTime::currentDateTime() )
+	,	m_timestampMode( RealtimeClock )
+	,	m_timestamp( 0 )
 	,	m_desc( desc )
 	,	m_value( value )
+	,	m_rawValue( NoRawValue )
+	,	m_rawInteger( 0 )
+	,	m_rawDouble( 0.0 )
+	,	m_maxPublishRate( qMax( maxPublishRate, 0 ) )
 {
+	updateTimestamp();
+
 	initSource();
 }
 
@@ -74,9 +234,16 @@ Source::Source( const Source & other )
 	,	m_name( other.name() )
 	,	m_typeName( other.typeName() )
 	,	m_serverSocket( Q_NULLPTR )
-	,	m_dateTime( other.dateTime() )
+	,	m_timestampMode( other.m_timestampMode )
+	,	m_dateTime( other.m_dateTime )
+	,	m_timestamp( other.m_timestamp )
 	,	m_desc( other.description() )
-	,	m_value( other.value() )
+	,	m_value( other.m_value )
+	,	m_rawValue( other.m_rawValue )
+	,	m_rawInteger( other.m_rawInteger )
+	,	m_rawDouble( other.m_rawDouble )
+	,	m_rawString( other.m_rawString )
+	,	m_maxPublishRate( other.maxPublishRate() )
 {
 }
 
@@ -89,9 +256,16 @@ Source::operator = ( const Source & other )
 		m_name = other.name();
 		m_typeName = other.typeName();
 		m_serverSocket = Q_NULLPTR;
-		m_dateTime = other.dateTime();
+		m_timestampMode = other.m_timestampMode;
+		m_dateTime = other.m_dateTime;
+		m_timestamp = other.m_timestamp;
 		m_desc = other.description();
-		m_value = other.value();
+		m_value = other.m_value;
+		m_rawValue = other.m_rawValue;
+		m_rawInteger = other.m_rawInteger;
+		m_rawDouble = other.m_rawDouble;
+		m_rawString = other.m_rawString;
+		m_maxPublishRate = other.maxPublishRate();
 	}
 
 	return *this;
@@ -111,27 +285,113 @@ Source::deinitSource()
 		m_serverSocket->deinitSource( *this );
 }
 
-const QVariant &
+QVariant
 Source::value() const
 {
-	return m_value;
-}
+	switch( m_rawValue )
+	{
+		case SignedRawValue :
+			return integerValue( m_type, m_rawInteger, false );
+
+		case UnsignedRawValue :
+			return integerValue( m_type, m_rawInteger, true );
 
+		case DoubleRawValue :
+			return convertedValue( m_type, QVariant( m_rawDouble ) );
+
+		case StringRawValue :
+			return convertedValue( m_type, QVariant( m_rawString ) );
+
+		default :
+			return m_value;
+	}
+}
 
 void
 Source::setValue( const QVariant & v )
 {
 	m_value = v;
+	m_rawValue = NoRawValue;
+	m_rawString = QString();
 
-	m_dateTime = QDateTime::currentDateTime();
+	sendUpdate();
+}
 
-	if( m_serverSocket )
-		m_serverSocket->updateSource( *this );
+void
+Source::setValue( qint64 v )
+{
+	Q_ASSERT_X( isIntegerFit( m_type, v, false ), "Source::setValue",
+		"Value doesn't fit into the type of the source." );
+
+	m_rawInteger = v;
+	m_rawValue = SignedRawValue;
+
+	sendUpdate();
+}
+
+void
+Source::setValue( quint64 v )
+{
+	Q_ASSERT_X( isIntegerFit( m_type, (qint64) v, true ), "Source::setValue",
+		"Value doesn't fit into the type of the source." );
+
+	m_rawInteger = (qint64) v;
+	m_rawValue = UnsignedRawValue;
+
+	sendUpdate();
+}
+
+void
+Source::setValue( int v )
+{
+	setValue( (qint64) v );
 }
 
-const QDateTime &
+void
+Source::setValue( uint v )
+{
+	setValue( (quint64) v );
+}
+
+void
+Source::setValue( double v )
+{
+	Q_ASSERT_X( m_type != DateTime && m_type != Time, "Source::setValue",
+		"Number can't be value of the source of date or time." );
+
+	m_rawDouble = v;
+	m_rawValue = DoubleRawValue;
+
+	sendUpdate();
+}
+
+void
+Source::setValue( QString && v )
+{
+	m_rawString = std::move( v );
+	m_rawValue = StringRawValue;
+
+	sendUpdate();
+}
+
+void
+Source::setValue( const char * v )
+{
+	setValue( QString::fromUtf8( v ) );
+}
+
+void
+Source::setValue( QLatin1String v )
+{
+	setValue( QString( v ) );
+}
+
+QDateTime
 Source::dateTime() const
 {
+	if( m_timestamp )
+		return QDateTime::fromMSecsSinceEpoch( m_timestamp / 1000000 );
+
 	return m_dateTime;
 }
 
@@ -139,11 +399,24 @@ void
 Source::setDateTime( const QDateTime & dt )
 {
 	m_dateTime = dt;
+	m_timestamp = 0;
 
 	if( m_serverSocket )
 		m_serverSocket->updateSource( *this );
 }
 
+Source::TimestampMode
+Source::timestampMode() const
+{
+	return m_timestampMode;
+}
+
+void
+Source::setTimestampMode( TimestampMode mode )
+{
+	m_timestampMode = mode;
+}
+
 Source::Type
 Source::type() const
 {
@@ -192,6 +465,18 @@ Source::setDescription( const QString & desc )
 	m_desc = desc;
 }
 
+int
+Source::maxPublishRate() const
+{
+	return m_maxPublishRate;
+}
+
+void
+Source::setMaxPublishRate( int rate )
+{
+	m_maxPublishRate = qMax( rate, 0 );
+}
+
 ServerSocket *
 Source::serverSocket() const
 {
@@ -208,6 +493,44 @@ Source::setServerSocket( ServerSocket * socket )
 	initSource();
 }
 
+void
+Source::updateTimestamp()
+{
+	if( m_timestampMode == CurrentDateTime )
+	{
+		m_dateTime = QDateTime::currentDateTime();
+		m_timestamp = 0;
+	}
+	else
+		m_timestamp = realtimeClock( m_timestampMode == CoarseRealtimeClock );
+}
+
+void
+Source::sendUpdate()
+{
+	updateTimestamp();
+
+	if( m_serverSocket )
+		m_serverSocket->updateSource( *this );
+}
+
+void
+Source::convertRawData()
+{
+	if( m_rawValue != NoRawValue )
+	{
+		m_value = value();
+		m_rawValue = NoRawValue;
+		m_rawString = QString();
+	}
+
+	if( m_timestamp )
+	{
+		m_dateTime = dateTime();
+		m_timestamp = 0;
+	}
+}
+
 bool operator == ( const Source & s1, const Source & s2 )
 {
 	return ( s1.name() == s2.name() &&
@@ -80,6 +80,25 @@ public:
 		Time = 0x08
 	}; /* enum Type */
 
+	//! Way of taking date and time of the update in setValue().
+	enum TimestampMode {
+		//! QDateTime::currentDateTime() on each update.
+		CurrentDateTime,
+		/*!
+			Realtime clock in nanoseconds, converted to QDateTime
+			only when date and time is read, for example when
+			the update is sent out. Default.
+		*/
+		RealtimeClock,
+		/*!
+			Like RealtimeClock, but coarse clock of the system is used
+			where available (CLOCK_REALTIME_COARSE). It's cheaper, but
+			its resolution is the system tick, usually 1-4 ms.
+			For sources with very high rate of updates.
+		*/
+		CoarseRealtimeClock
+	}; /* enum TimestampMode */
+
 	//! Type of the source will be Int.
 	Source();
 
@@ -98,7 +117,9 @@ public:
 			Server socket. If not null then source will
 			send out the information about itself.
 		*/
-		ServerSocket * serverSocket = Q_NULLPTR );
+		ServerSocket * serverSocket = Q_NULLPTR,
+		//! Maximum publish rate, zero means unlimited.
+		int maxPublishRate = 0 );
 
 	~Source();
 
@@ -131,21 +152,65 @@ public:
 	*/
 	void deinitSource();
 
-	//! \return Value of the source.
-	const QVariant & value() const;
+	/*!
+		\return Value of the source.
+
+		Value set with typed setValue() is converted to QVariant on
+		each read, the source itself isn't modified, so const source
+		can be read from many threads.
+	*/
+	QVariant value() const;
 	/*!
 		Set value of the source. If serverSocket was defined in the
 		constructor then information will send out.
 
-		m_dateTime updates automatically to current system date and time.
+		m_dateTime updates automatically to current system date and time
+		in the way defined by timestampMode().
 	*/
 	void setValue( const QVariant & v );
+	/*!
+		Set integer value of the source without construction of QVariant.
+
+		Value is kept as is and converted to QVariant of the type
+		of the source only when it's read, for example by the thread
+		of the ServerSocket when the update is sent out. Typed values
+		of other types are converted too, for example integer is
+		converted to string for String source and double is rounded
+		for Int source. Value must fit into the type of the source:
+		it's asserted that integers aren't truncated and numbers
+		aren't set to sources of date or time.
+	*/
+	void setValue( qint64 v );
+	//! Set unsigned integer value of the source, see setValue( qint64 ).
+	void setValue( quint64 v );
+	//! Set integer value of the source, see setValue( qint64 ).
+	void setValue( int v );
+	//! Set unsigned integer value of the source, see setValue( qint64 ).
+	void setValue( uint v );
+	//! Set double value of the source, see setValue( qint64 ).
+	void setValue( double v );
+	//! Set string value of the source, see setValue( qint64 ).
+	void setValue( QString && v );
+	//! Set UTF-8 string value of the source, see setValue( qint64 ).
+	void setValue( const char * v );
+	//! Set Latin-1 string value of the source, see setValue( qint64 ).
+	void setValue( QLatin1String v );
+
+	/*!
+		\return Time of the update.
 
-	//! \return Time of the update.
-	const QDateTime & dateTime() const;
+		Raw timestamp is converted on each read, the source
+		itself isn't modified.
+	*/
+	QDateTime dateTime() const;
 	//! Set date and time.
 	void setDateTime( const QDateTime & dt );
 
+	//! \return Way of taking date and time of the update.
+	TimestampMode timestampMode() const;
+	//! Set way of taking date and time of the update.
+	void setTimestampMode( TimestampMode mode );
+
 	//! \return Type of the source.
 	Type type() const;
 	//! Set type of the source.
@@ -166,6 +231,19 @@ public:
 	//! Set description of the source.
 	void setDescription( const QString & desc );
 
+	//! \return Maximum count of values sent out per second.
+	int maxPublishRate() const;
+	/*!
+		Set maximum count of values sent out per second. Zero
+		(by default) means unlimited.
+
+		ServerSocket keeps only the newest value within the
+		window and sends it when the window closes, so the
+		final value is always sent out. New rate is applied
+		with the next value of the source.
+	*/
+	void setMaxPublishRate( int rate );
+
 	//! \return Server socket.
 	ServerSocket * serverSocket() const;
 	/*!
@@ -182,7 +260,34 @@ public:
 	//! Not-equality operator.
 	friend bool operator != ( const Source & s1, const Source & s2 );
 
+	//! ServerSocket converts raw data of the received sources.
+	friend class ServerSocket;
+
 private:
+	//! Kind of the value not converted to m_value yet.
+	enum RawValue {
+		//! m_value is actual.
+		NoRawValue,
+		//! Value is in m_rawInteger.
+		SignedRawValue,
+		//! Value is in m_rawInteger as quint64.
+		UnsignedRawValue,
+		//! Value is in m_rawDouble.
+		DoubleRawValue,
+		//! Value is in m_rawString.
+		StringRawValue
+	}; /* enum RawValue */
+
+	//! Take date and time of the update.
+	void updateTimestamp();
+	//! Send out the update if server socket is set.
+	void sendUpdate();
+	/*!
+		Convert raw value and timestamp to m_value and m_dateTime,
+		so reads of the source don't convert them again.
+	*/
+	void convertRawData();
+
 	//! Type of the source.
 	Type m_type;
 	//! Name of the source.
@@ -191,12 +296,29 @@ private:
 	QString m_typeName;
 	//! Server socket.
 	ServerSocket * m_serverSocket;
-	//! Date and time of the update.
+	//! Way of taking date and time of the update.
+	TimestampMode m_timestampMode;
+	//! Date and time of the update, actual if m_timestamp is zero.
 	QDateTime m_dateTime;
+	/*!
+		Nanoseconds since epoch of the update not converted
+		to m_dateTime yet, zero if m_dateTime is actual.
+	*/
+	qint64 m_timestamp;
 	//! Description of the source.
 	QString m_desc;
-	//! Value of the source.
+	//! Value of the source, actual if m_rawValue is NoRawValue.
 	QVariant m_value;
+	//! Kind of the value not converted to m_value yet.
+	RawValue m_rawValue;
+	//! Raw integer value.
+	qint64 m_rawInteger;
+	//! Raw double value.
+	double m_rawDouble;
+	//! Raw string value.
+	QString m_rawString;
+	//! Maximum publish rate.
+	int m_maxPublishRate;
 }; /* class Source */
 
 } /* namespace Como */
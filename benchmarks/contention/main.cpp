@@ -0,0 +1,131 @@
+
+/*!
+	\file
+
+	\author Igor Mironchik (igor.mironchik at gmail dot com).
+
+	Copyright (c) 2012 Igor Mironchik
+
+	Permission is hereby granted, free of charge, to any person
+	obtaining a copy of this software and associated documentation
+	files (the "Software"), to deal in the Software without
+	restriction, including without limitation the rights to use,
+	copy, modify, merge, publish, distribute, sublicense, and/or sell
+	copies of the Software, and to permit persons to whom the
+	Software is furnished to do so, subject to the following
+	conditions:
+
+	The above copyright notice and this permission notice shall be
+	included in all copies or substantial portions of the Software.
+
+	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+	EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+	OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+	NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+	HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+	WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+	FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+	OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+// Como include.
+#include <Como/ServerSocket>
+#include <Como/Source>
+
+// Qt include.
+#include <QCoreApplication>
+#include <QElapsedTimer>
+#include <QTextStream>
+#include <QThread>
+#include <QList>
+#include <QString>
+
+
+//! Count of updates made by each producer.
+static const int c_updatesCount = 20000;
+
+
+//
+// runProducers
+//
+
+/*!
+	Run producers, each of them updates own source
+	c_updatesCount times. Queued operations are processed
+	by the thread of the ServerSocket in the meantime.
+
+	\return Elapsed time in nanoseconds.
+*/
+static qint64
+runProducers( Como::ServerSocket * socket, int producersCount )
+{
+	QList< QThread* > producers;
+
+	for( int i = 0; i < producersCount; ++i )
+	{
+		producers.append( QThread::create( [ socket, i ] () {
+			Como::Source source( Como::Source::Int,
+				QString( "benchmark.contention.%1" ).arg( i ),
+				QLatin1String( "IntSource" ),
+				QVariant( 0 ),
+				QLatin1String( "Source used in the contention benchmark." ),
+				socket );
+
+			for( int j = 1; j <= c_updatesCount; ++j )
+				source.setValue( QVariant( j ) );
+		} ) );
+	}
+
+	QElapsedTimer timer;
+	timer.start();
+
+	foreach( QThread * producer, producers )
+		producer->start();
+
+	bool running = true;
+
+	while( running )
+	{
+		QCoreApplication::processEvents();
+
+		running = false;
+
+		foreach( QThread * producer, producers )
+			running = running || !producer->isFinished();
+	}
+
+	const qint64 elapsed = timer.nsecsElapsed();
+
+	QCoreApplication::sendPostedEvents();
+
+	qDeleteAll( producers );
+
+	return elapsed;
+}
+
+
+int main( int argc, char ** argv )
+{
+	QCoreApplication app( argc, argv );
+
+	QTextStream out( stdout );
+
+	Como::ServerSocket socket;
+
+	out << "producers\tupdates/s\tns/update\n";
+
+	static const int producers[] = { 1, 2, 4, 8, 16, 32, 64 };
+
+	for( int count : producers )
+	{
+		const qint64 elapsed = runProducers( &socket, count );
+		const qint64 updates = qint64( count ) * c_updatesCount;
+
+		out << count << "\t"
+			<< updates * 1000000000LL / qMax( elapsed, qint64( 1 ) ) << "\t"
+			<< elapsed / updates << "\n";
+		out.flush();
+	}
+
+	return 0;
+}
@@ -0,0 +1,299 @@
+
+/*!
+	\file
+
+	\author Igor Mironchik (igor.mironchik at gmail dot com).
+
+	Copyright (c) 2012 Igor Mironchik
+
+	Permission is hereby granted, free of charge, to any person
+	obtaining a copy of this software and associated documentation
+	files (the "Software"), to deal in the Software without
+	restriction, including without limitation the rights to use,
+	copy, modify, merge, publish, distribute, sublicense, and/or sell
+	copies of the Software, and to permit persons to whom the
+	Software is furnished to do so, subject to the following
+	conditions:
+
+	The above copyright notice and this permission notice shall be
+	included in all copies or substantial portions of the Software.
+
+	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+	EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+	OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+	NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+	HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+	WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+	FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+	OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+// Como include.
+#include <Como/Source>
+#include <Como/private/Protocol>
+#include <Como/private/Messages>
+
+// Qt include.
+#include <QCoreApplication>
+#include <QElapsedTimer>
+#include <QTextStream>
+#include <QDataStream>
+#include <QByteArray>
+#include <QByteArrayView>
+#include <QDateTime>
+#include <QVariant>
+
+
+//! Count of messages in each measurement.
+static const int c_messagesCount = 100000;
+
+
+//
+// decodeWithDataStream
+//
+
+/*!
+	Old decoding: QDataStream over the receive buffer for the header,
+	copy of the payload and one more QDataStream for the fields.
+
+	\return Elapsed time in nanoseconds.
+*/
+static qint64
+decodeWithDataStream( const QByteArray & buf )
+{
+	QElapsedTimer timer;
+	timer.start();
+
+	int pos = 0;
+	int decoded = 0;
+
+	while( pos < buf.size() )
+	{
+		QDataStream header( QByteArray::fromRawData( buf.constData() + pos,
+			buf.size() - pos ) );
+		header.setVersion( QDataStream::Qt_4_0 );
+
+		quint64 magicNumber = 0;
+		quint16 type = 0;
+		quint16 length = 0;
+
+		header >> magicNumber >> type >> length;
+
+		const QByteArray msgData = buf.mid( pos + 12, length );
+
+		QDataStream dataStream( msgData );
+		dataStream.setVersion( QDataStream::Qt_4_0 );
+
+		if( type == Como::SourceMessage::messageType )
+		{
+			quint16 sourceType = 0;
+			QString name;
+			QString typeName;
+			QDateTime dateTime;
+			QString description;
+			QVariant value;
+
+			dataStream >> sourceType >> name >> typeName >> dateTime
+				>> description >> value;
+		}
+		else if( type == Como::SourceDeltaMessage::messageType )
+		{
+			quint32 id = 0;
+			QDateTime dateTime;
+			quint8 byte = 0x80;
+
+			dataStream >> id >> dateTime;
+
+			while( ( byte & 0x80 ) && dataStream.status() == QDataStream::Ok )
+				dataStream >> byte;
+		}
+		else
+		{
+			quint32 id = 0;
+			QDateTime dateTime;
+			QVariant value;
+
+			dataStream >> id >> dateTime >> value;
+		}
+
+		if( dataStream.status() == QDataStream::Ok )
+			++decoded;
+
+		pos += 12 + length;
+	}
+
+	const qint64 elapsed = timer.nsecsElapsed();
+
+	return ( decoded == c_messagesCount ? elapsed : -1 );
+}
+
+
+//
+// decodeFromView
+//
+
+/*!
+	Decoding with Protocol::readMessage(): header and fields
+	are read from the view over the receive buffer, each
+	message is allocated on the heap.
+
+	\return Elapsed time in nanoseconds.
+*/
+static qint64
+decodeFromView( const QByteArray & buf )
+{
+	QElapsedTimer timer;
+	timer.start();
+
+	QByteArrayView view( buf );
+	int decoded = 0;
+
+	while( !view.isEmpty() )
+	{
+		int bytesRead = 0;
+
+		const QSharedPointer< Como::Message > msg =
+			Como::Protocol::readMessage( view, bytesRead,
+				Como::Protocol::Version1 );
+
+		if( msg.data() )
+			++decoded;
+
+		view = view.sliced( bytesRead );
+	}
+
+	const qint64 elapsed = timer.nsecsElapsed();
+
+	return ( decoded == c_messagesCount ? elapsed : -1 );
+}
+
+
+//
+// CountingVisitor
+//
+
+//! Visitor counting the decoded messages.
+class CountingVisitor
+	:	public Como::MessageVisitor
+{
+public:
+	CountingVisitor()
+		:	m_count( 0 )
+	{
+	}
+
+	virtual void visit( const Como::Message & )
+	{
+		++m_count;
+	}
+
+	//! Count of the decoded messages.
+	int m_count;
+}; // class CountingVisitor
+
+
+//
+// decodeWithVisitor
+//
+
+/*!
+	Decoding with MessageDecoder: messages are created on the
+	stack and passed to the visitor, nothing is allocated for them.
+
+	\return Elapsed time in nanoseconds.
+*/
+static qint64
+decodeWithVisitor( const QByteArray & buf )
+{
+	QElapsedTimer timer;
+	timer.start();
+
+	Como::MessageDecoder decoder( Como::Protocol::Version1 );
+	CountingVisitor visitor;
+	QByteArrayView view( buf );
+
+	while( !view.isEmpty() &&
+		decoder.decode( view, visitor ) == Como::MessageDecoder::MessageDecoded )
+			view = view.sliced( decoder.bytesRead() );
+
+	const qint64 elapsed = timer.nsecsElapsed();
+
+	return ( visitor.m_count == c_messagesCount ? elapsed : -1 );
+}
+
+
+//
+// printRow
+//
+
+//! Decode the buffer in all ways and print results.
+static void
+printRow( QTextStream & out, const char * name, const QByteArray & buf )
+{
+	const qint64 visitor = decodeWithVisitor( buf );
+
+	out << name << "\t"
+		<< decodeWithDataStream( buf ) / c_messagesCount << "\t"
+		<< decodeFromView( buf ) / c_messagesCount << "\t"
+		<< visitor / c_messagesCount << "\t"
+		<< ( visitor > 0 ? c_messagesCount * 1000000000LL / visitor : 0 )
+		<< "\n";
+	out.flush();
+}
+
+
+//
+// writeMessages
+//
+
+//! \return Receive buffer with c_messagesCount copies of the message.
+static QByteArray
+writeMessages( const Como::Message & msg )
+{
+	const QSharedPointer< QByteArray > data =
+		Como::Protocol::writeMessage( msg, Como::Protocol::Version1 );
+
+	QByteArray buf;
+	buf.reserve( data->size() * c_messagesCount );
+
+	for( int i = 0; i < c_messagesCount; ++i )
+		buf.append( *data );
+
+	return buf;
+}
+
+
+int main( int argc, char ** argv )
+{
+	QCoreApplication app( argc, argv );
+
+	QTextStream out( stdout );
+
+	const Como::Source source( Como::Source::String,
+		QLatin1String( "benchmark.decode.source" ),
+		QLatin1String( "StringSource" ),
+		QVariant( QLatin1String( "Some value of the source" ) ),
+		QLatin1String( "Source used in the decode benchmark." ) );
+
+	const Como::Source doubleSource( Como::Source::Double,
+		QLatin1String( "benchmark.decode.double" ),
+		QLatin1String( "DoubleSource" ),
+		QVariant( 3.14 ),
+		QLatin1String( "Source used in the decode benchmark." ) );
+
+	out << "message\tQDataStream (ns/message)\treadMessage (ns/message)\t"
+		"visitor (ns/message)\tvisitor (messages/s)\n";
+
+	printRow( out, "Source",
+		writeMessages( Como::SourceMessage( source ) ) );
+
+	printRow( out, "SourceValue",
+		writeMessages( Como::SourceValueMessage( 1, doubleSource ) ) );
+
+	printRow( out, "SourceDelta",
+		writeMessages( Como::SourceDeltaMessage( 1, QDateTime::currentDateTime(),
+			Como::SourceDeltaMessage::encode( QVariant( 100 ),
+				QVariant( 101 ) ) ) ) );
+
+	return 0;
+}
@@ -0,0 +1,136 @@
+
+/*!
+	\file
+
+	\author Igor Mironchik (igor.mironchik at gmail dot com).
+
+	Copyright (c) 2012 Igor Mironchik
+
+	Permission is hereby granted, free of charge, to any person
+	obtaining a copy of this software and associated documentation
+	files (the "Software"), to deal in the Software without
+	restriction, including without limitation the rights to use,
+	copy, modify, merge, publish, distribute, sublicense, and/or sell
+	copies of the Software, and to permit persons to whom the
+	Software is furnished to do so, subject to the following
+	conditions:
+
+	The above copyright notice and this permission notice shall be
+	included in all copies or substantial portions of the Software.
+
+	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+	EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+	OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+	NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+	HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+	WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+	FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+	OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+// Como include.
+#include <Como/Source>
+#include <Como/private/Protocol>
+#include <Como/private/Messages>
+
+// Qt include.
+#include <QCoreApplication>
+#include <QElapsedTimer>
+#include <QTextStream>
+#include <QByteArray>
+#include <QList>
+#include <QVector>
+
+
+//! Count of updates in each measurement.
+static const int c_updatesCount = 2000;
+
+
+//
+// Sink
+//
+
+//! Write buffer of the one client.
+typedef QList< QByteArray > Sink;
+
+
+//
+// encodePerClient
+//
+
+//! Old fan-out: each client serializes the message itself.
+static qint64
+encodePerClient( const Como::Source & source, QVector< Sink > & sinks )
+{
+	QElapsedTimer timer;
+	timer.start();
+
+	for( int i = 0; i < c_updatesCount; ++i )
+	{
+		for( Sink & sink : sinks )
+			sink.append( *Como::Protocol::writeMessage(
+				Como::SourceMessage( source ) ) );
+	}
+
+	return timer.nsecsElapsed();
+}
+
+
+//
+// encodeOnce
+//
+
+//! New fan-out: message serialized once and shared by all clients.
+static qint64
+encodeOnce( const Como::Source & source, QVector< Sink > & sinks )
+{
+	QElapsedTimer timer;
+	timer.start();
+
+	for( int i = 0; i < c_updatesCount; ++i )
+	{
+		const QSharedPointer< QByteArray > data =
+			Como::Protocol::writeMessage( Como::SourceMessage( source ) );
+
+		for( Sink & sink : sinks )
+			sink.append( *data );
+	}
+
+	return timer.nsecsElapsed();
+}
+
+
+int main( int argc, char ** argv )
+{
+	QCoreApplication app( argc, argv );
+
+	QTextStream out( stdout );
+
+	const Como::Source source( Como::Source::String,
+		QLatin1String( "benchmark.fanout.source" ),
+		QLatin1String( "StringSource" ),
+		QVariant( QLatin1String( "Some value of the source" ) ),
+		QLatin1String( "Source used in the fan-out benchmark." ) );
+
+	out << "clients\tper-client (ns/update)\tshared (ns/update)\n";
+
+	static const int clients[] = { 1, 10, 50, 100, 200 };
+
+	for( int count : clients )
+	{
+		QVector< Sink > sinks( count );
+
+		const qint64 perClient = encodePerClient( source, sinks );
+
+		sinks.fill( Sink() );
+
+		const qint64 shared = encodeOnce( source, sinks );
+
+		out << count << "\t"
+			<< perClient / c_updatesCount << "\t"
+			<< shared / c_updatesCount << "\n";
+		out.flush();
+	}
+
+	return 0;
+}
@@ -0,0 +1,127 @@
+
+/*!
+	\file
+
+	\author Igor Mironchik (igor.mironchik at gmail dot com).
+
+	Copyright (c) 2012 Igor Mironchik
+
+	Permission is hereby granted, free of charge, to any person
+	obtaining a copy of this software and associated documentation
+	files (the "Software"), to deal in the Software without
+	restriction, including without limitation the rights to use,
+	copy, modify, merge, publish, distribute, sublicense, and/or sell
+	copies of the Software, and to permit persons to whom the
+	Software is furnished to do so, subject to the following
+	conditions:
+
+	The above copyright notice and this permission notice shall be
+	included in all copies or substantial portions of the Software.
+
+	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+	EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+	OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+	NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+	HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+	WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+	FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+	OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+// Como include.
+#include <Como/ServerSocket>
+#include <Como/Source>
+
+// Qt include.
+#include <QCoreApplication>
+#include <QElapsedTimer>
+#include <QTextStream>
+#include <QString>
+#include <QVariant>
+
+
+//! Count of updates in each measurement.
+static const int c_updatesCount = 200000;
+
+
+//
+// measure
+//
+
+/*!
+	Update source c_updatesCount times with the given setter
+	and process queued operations of the server socket.
+
+	\return Nanoseconds per update.
+*/
+template< class Setter >
+static qint64
+measure( Como::Source & source, Setter setter )
+{
+	QElapsedTimer timer;
+	timer.start();
+
+	for( int i = 1; i <= c_updatesCount; ++i )
+		setter( source, i );
+
+	QCoreApplication::sendPostedEvents();
+
+	return timer.nsecsElapsed() / c_updatesCount;
+}
+
+
+//
+// printRow
+//
+
+//! Print nanoseconds per update of both paths with and without server.
+template< class VariantSetter, class TypedSetter >
+static void
+printRow( QTextStream & out, Como::ServerSocket * socket,
+	Como::Source::Type type, const QString & typeName,
+	VariantSetter variantSetter, TypedSetter typedSetter )
+{
+	Como::Source local( type, QString( "benchmark.setters.local" ),
+		typeName, QVariant(), QLatin1String( "Local source." ) );
+
+	Como::Source served( type, QString( "benchmark.setters.served" ),
+		typeName, QVariant(), QLatin1String( "Served source." ), socket );
+
+	out << typeName << "\t"
+		<< measure( local, variantSetter ) << "\t"
+		<< measure( local, typedSetter ) << "\t"
+		<< measure( served, variantSetter ) << "\t"
+		<< measure( served, typedSetter ) << "\n";
+	out.flush();
+}
+
+
+int main( int argc, char ** argv )
+{
+	QCoreApplication app( argc, argv );
+
+	QTextStream out( stdout );
+
+	Como::ServerSocket socket;
+
+	out << "type\tQVariant ns\ttyped ns\t"
+		"QVariant+server ns\ttyped+server ns\n";
+
+	printRow( out, &socket, Como::Source::LongLong,
+		QLatin1String( "LongLong" ),
+		[] ( Como::Source & s, int i ) { s.setValue( QVariant( (qlonglong) i ) ); },
+		[] ( Como::Source & s, int i ) { s.setValue( (qint64) i ); } );
+
+	printRow( out, &socket, Como::Source::Double,
+		QLatin1String( "Double" ),
+		[] ( Como::Source & s, int i ) { s.setValue( QVariant( i * 0.5 ) ); },
+		[] ( Como::Source & s, int i ) { s.setValue( i * 0.5 ); } );
+
+	printRow( out, &socket, Como::Source::String,
+		QLatin1String( "String" ),
+		[] ( Como::Source & s, int i ) {
+			s.setValue( QVariant( QString::number( i ) ) ); },
+		[] ( Como::Source & s, int i ) { s.setValue( QString::number( i ) ); } );
+
+	return 0;
+}
@@ -48,6 +48,8 @@ main( int argc, char ** argv )
 	QApplication app( argc, argv );
 
 	Como::ClientSocket socket;
+	// Sample server supports the protocol #2.
+	socket.setProtocol2Enabled( true );
 
 	MainWindow mainWindow( &socket );
 
@@ -108,12 +108,12 @@ MainWindow::slotQuit()
 void
 MainWindow::slotConnected()
 {
-	d->m_socket->sendGetListOfSourcesMessage();
+	// Receive only updates missed while we were disconnected.
+	d->m_socket->sendResumeMessage();
 }
 
 void
 MainWindow::slotDisconnected()
 {
-	d->m_model->clear();
 	d->m_socket->connectTo( QHostAddress::LocalHost, 4545 );
 }